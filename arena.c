@@ -0,0 +1,102 @@
+// Slab allocator for memory that is freed all at once
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arena.h"
+
+// Size of the data in a standard slab
+#define SLAB_SIZE (64 * 1024)
+
+// Every allocation starts on a multiple of this many bytes
+#define ARENA_ALIGNMENT 16
+
+struct arena {
+    struct slab *slabs; // Slab currently being carved up, then older slabs
+    size_t used;        // Bytes already handed out from the current slab
+};
+
+// Header of one slab, the slab's data directly follows it
+struct slab {
+    struct slab *next;
+    size_t size;
+};
+
+static struct slab *new_slab(size_t size);
+static char *slab_data(struct slab *slab);
+
+Arena new_arena(void) {
+    Arena arena = malloc(sizeof(struct arena));
+    assert(arena != NULL);
+    arena->slabs = NULL;
+    arena->used = 0;
+    return arena;
+}
+
+// Hands out the next aligned piece of the current slab, starting a new
+// slab when it is full
+void *arena_alloc(Arena arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+    if (size == 0) {
+        size = ARENA_ALIGNMENT;
+    }
+
+    // Large requests get a slab of their own, placed behind the current
+    // slab so the rest of the current slab can still be used
+    if (size > SLAB_SIZE / 4) {
+        struct slab *slab = new_slab(size);
+        if (arena->slabs == NULL) {
+            slab->next = NULL;
+            arena->slabs = slab;
+            arena->used = size;
+        } else {
+            slab->next = arena->slabs->next;
+            arena->slabs->next = slab;
+        }
+        return slab_data(slab);
+    }
+
+    if (arena->slabs == NULL || arena->used + size > arena->slabs->size) {
+        struct slab *slab = new_slab(SLAB_SIZE);
+        slab->next = arena->slabs;
+        arena->slabs = slab;
+        arena->used = 0;
+    }
+    void *memory = slab_data(arena->slabs) + arena->used;
+    arena->used += size;
+    return memory;
+}
+
+// Copies the string (including its '\0') into the arena
+char *arena_strdup(Arena arena, const char *string) {
+    size_t length = strlen(string) + 1;
+    char *copy = arena_alloc(arena, length);
+    memcpy(copy, string, length);
+    return copy;
+}
+
+// Frees every slab and then the arena
+void destroy_arena(Arena arena) {
+    struct slab *slab = arena->slabs;
+    while (slab != NULL) {
+        struct slab *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    free(arena);
+}
+
+// Mallocs a slab with room for `size` bytes of data
+static struct slab *new_slab(size_t size) {
+    struct slab *slab = malloc(sizeof(struct slab) + size);
+    assert(slab != NULL);
+    slab->next = NULL;
+    slab->size = size;
+    return slab;
+}
+
+// Returns the start of the slab's data, which directly follows its header
+static char *slab_data(struct slab *slab) {
+    return (char *) slab + sizeof(struct slab);
+}
\ No newline at end of file
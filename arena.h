@@ -0,0 +1,29 @@
+// Slab allocator for memory that is freed all at once
+
+#include <stddef.h>
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+typedef struct arena *Arena;
+
+// Create a new, empty arena.
+// It is the caller's responsibility to call 'destroy_arena' to free all
+// of the memory handed out by the arena.
+Arena new_arena(void);
+
+// Return `size` bytes of memory from the arena, suitably aligned for
+// any type.
+//
+// Memory is carved out of large contiguous slabs, so consecutive
+// allocations are usually adjacent in memory. The memory cannot be
+// freed on its own, it is only released by 'destroy_arena'.
+void *arena_alloc(Arena arena, size_t size);
+
+// Return a copy of `string` whose memory comes from the arena.
+char *arena_strdup(Arena arena, const char *string);
+
+// Free every slab of the arena, and the arena itself.
+void destroy_arena(Arena arena);
+
+#endif // _ARENA_H_
\ No newline at end of file
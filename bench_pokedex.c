@@ -0,0 +1,1138 @@
+// Benchmarks for pokedex.c
+//
+// Each benchmark builds Pokedexes of increasing size and reports the
+// average cost of one operation, so that operations which should take
+// constant time can be checked to stay flat as the Pokedex grows.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "pokedex.h"
+#include "csv_import.h"
+#include "sharded_pokedex.h"
+
+#define MAX_NAME_LENGTH 16
+#define MAX_BENCH_THREADS 32
+#define N_SIZES 4
+
+// What one thread of bench_concurrent does: `n_ops` requests to the
+// Pokedex, adding Pokemon with IDs from `first_id`, each request made
+// while holding `mutex` unless it is NULL
+struct bench_worker {
+    Pokedex pokedex;
+    pthread_mutex_t *mutex;
+    int first_id;
+    int n_ops;
+};
+
+// What one thread of bench_sharded does: add, find and sometimes remove
+// `n_pokemon` Pokemon with IDs from `first_id`
+struct sharded_worker {
+    ShardedPokedex sharded;
+    int first_id;
+    int n_pokemon;
+};
+
+static void bench_navigation(void);
+static void bench_add_and_count(void);
+static void bench_arena(void);
+static void bench_search(void);
+static void bench_views(void);
+static void bench_exploring(void);
+static void bench_id_ranges(void);
+static void bench_snapshot(void);
+static void bench_import(void);
+static void bench_type_lookup(void);
+static void bench_accessors(void);
+static void bench_compact(void);
+static void bench_concurrent(void);
+static void bench_sharded(void);
+static void bench_parallel_queries(void);
+static void bench_evolutions(void);
+static double run_workers(Pokedex pokedex, pthread_mutex_t *mutex,
+    int n_threads, int n_ops);
+static void *serve_requests(void *worker);
+static double run_ingest(ShardedPokedex sharded, int n_threads, int n_pokemon);
+static void *ingest_pokemon(void *worker);
+
+// Helper functions for building Pokedexes and timing operations.
+static Pokedex build_pokedex(int size);
+static void fill_pokedex(Pokedex pokedex, int size);
+static void make_name(int id, char *name);
+static void make_search_name(int id, char *name);
+static void find_every_pokemon(Pokedex pokedex);
+static int linear_search_count(Pokedex pokedex, char *text);
+static int linear_prev_evolution(Pokedex pokedex, int id);
+static void write_csv(char *path, int size);
+static Pokedex import_line_by_line(char *path);
+static pokemon_type linear_type_from_string(char *text);
+static double now_seconds(void);
+
+static const int sizes[N_SIZES] = {1000, 10000, 100000, 1000000};
+
+int main(int argc, char *argv[]) {
+    printf("==================== Pokedex Benchmarks ====================\n");
+
+    bench_navigation();
+    bench_add_and_count();
+    bench_arena();
+    bench_search();
+    bench_views();
+    bench_exploring();
+    bench_id_ranges();
+    bench_snapshot();
+    bench_import();
+    bench_type_lookup();
+    bench_accessors();
+    bench_compact();
+    bench_concurrent();
+    bench_sharded();
+    bench_parallel_queries();
+    bench_evolutions();
+
+    return 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//                     Pokedex Benchmarks                             //
+////////////////////////////////////////////////////////////////////////
+
+// `bench_navigation` walks the currently selected Pokemon from the start
+// of the Pokedex to the end with next_pokemon and back again with
+// prev_pokemon, reading the current Pokemon after every step.
+//
+// The cost per step should not depend on the size of the Pokedex.
+static void bench_navigation(void) {
+    printf("\n>> next_pokemon / prev_pokemon / get_current_pokemon\n");
+    printf("    %10s %14s\n", "pokemon", "ns per step");
+
+    int i = 0;
+    while (i < N_SIZES) {
+        int size = sizes[i];
+        Pokedex pokedex = build_pokedex(size);
+
+        long checksum = 0;
+        double start = now_seconds();
+        int step = 1;
+        while (step < size) {
+            next_pokemon(pokedex);
+            checksum += pokemon_id(get_current_pokemon(pokedex));
+            step += 1;
+        }
+        step = 1;
+        while (step < size) {
+            prev_pokemon(pokedex);
+            checksum += pokemon_id(get_current_pokemon(pokedex));
+            step += 1;
+        }
+        double elapsed = now_seconds() - start;
+        assert(checksum == (long) (size - 1) * (size - 1));
+
+        printf("    %10d %14.1f\n", size, elapsed * 1e9 / (2.0 * (size - 1)));
+        destroy_pokedex(pokedex);
+        i += 1;
+    }
+}
+
+// `bench_add_and_count` times appending Pokemon with add_pokemon, then
+// polling count_total_pokemon and count_found_pokemon.
+//
+// Both costs should not depend on the size of the Pokedex.
+static void bench_add_and_count(void) {
+    printf("\n>> add_pokemon / count_total_pokemon / count_found_pokemon\n");
+    printf("    %10s %14s %14s\n", "pokemon", "ns per add", "ns per count");
+
+    int i = 0;
+    while (i < N_SIZES) {
+        int size = sizes[i];
+
+        double start = now_seconds();
+        Pokedex pokedex = build_pokedex(size);
+        double add_elapsed = now_seconds() - start;
+
+        long checksum = 0;
+        int polls = 1000000;
+        start = now_seconds();
+        int poll = 0;
+        while (poll < polls) {
+            checksum += count_total_pokemon(pokedex);
+            checksum += count_found_pokemon(pokedex);
+            poll += 1;
+        }
+        double count_elapsed = now_seconds() - start;
+        assert(checksum == (long) polls * size);
+
+        printf("    %10d %14.1f %14.2f\n", size, add_elapsed * 1e9 / size,
+            count_elapsed * 1e9 / (2.0 * polls));
+        destroy_pokedex(pokedex);
+        i += 1;
+    }
+}
+
+// `bench_arena` compares loading and then destroying a Pokedex made with
+// new_pokedex (one malloc each for the pokenode, Pokemon and name) to
+// one made with new_arena_pokedex and new_pokedex_pokemon.
+static void bench_arena(void) {
+    printf("\n>> new_pokedex vs new_arena_pokedex (load + destroy)\n");
+    printf("    %10s %14s %14s\n", "pokemon", "malloc ns", "arena ns");
+
+    int i = 0;
+    while (i < N_SIZES) {
+        int size = sizes[i];
+
+        double start = now_seconds();
+        Pokedex pokedex = build_pokedex(size);
+        destroy_pokedex(pokedex);
+        double heap_elapsed = now_seconds() - start;
+
+        start = now_seconds();
+        pokedex = new_arena_pokedex();
+        fill_pokedex(pokedex, size);
+        destroy_pokedex(pokedex);
+        double arena_elapsed = now_seconds() - start;
+
+        printf("    %10d %14.1f %14.1f\n", size, heap_elapsed * 1e9 / size,
+            arena_elapsed * 1e9 / size);
+        i += 1;
+    }
+}
+
+// `bench_search` types a name one letter at a time, as an autocomplete
+// box would, and times search_pokemon for each prefix against a scan of
+// every name in the Pokedex. Every Pokemon is found first, so every name
+// is searched.
+//
+// The first search on a Pokedex builds its name index, and is timed
+// separately.
+static void bench_search(void) {
+    printf("\n>> search_pokemon vs linear scan (per keystroke)\n");
+    printf("    %10s %14s %14s %14s\n", "pokemon", "build us", "index us",
+        "scan us");
+
+    char *typed = "Zubatqe";
+    int keystrokes = strlen(typed);
+    int rounds = 10;
+
+    int i = 0;
+    while (i < N_SIZES) {
+        int size = sizes[i];
+        Pokedex pokedex = new_pokedex();
+        char name[MAX_NAME_LENGTH];
+        int id = 0;
+        while (id < size) {
+            make_search_name(id, name);
+            add_pokemon(pokedex, new_pokedex_pokemon(pokedex, id, name, 1.0,
+                10.0, NORMAL_TYPE, NONE_TYPE));
+            next_pokemon(pokedex);
+            find_current_pokemon(pokedex);
+            id += 1;
+        }
+
+        double start = now_seconds();
+        destroy_pokedex(search_pokemon(pokedex, "a"));
+        double build_elapsed = now_seconds() - start;
+
+        char query[MAX_NAME_LENGTH];
+        double index_elapsed = 0;
+        double scan_elapsed = 0;
+        int round = 0;
+        while (round < rounds) {
+            int length = 1;
+            while (length <= keystrokes) {
+                memcpy(query, typed, length);
+                query[length] = '\0';
+
+                start = now_seconds();
+                Pokedex results = search_pokemon(pokedex, query);
+                index_elapsed += now_seconds() - start;
+                int indexed = count_total_pokemon(results);
+                destroy_pokedex(results);
+
+                start = now_seconds();
+                int scanned = linear_search_count(pokedex, query);
+                scan_elapsed += now_seconds() - start;
+                assert(indexed == scanned);
+                length += 1;
+            }
+            round += 1;
+        }
+
+        int queries = rounds * keystrokes;
+        printf("    %10d %14.1f %14.1f %14.1f\n", size, build_elapsed * 1e6,
+            index_elapsed * 1e6 / queries, scan_elapsed * 1e6 / queries);
+        destroy_pokedex(pokedex);
+        i += 1;
+    }
+}
+
+// `bench_views` times get_pokemon_of_type, which copies every matching
+// Pokemon into a new Pokedex, against view_pokemon_of_type, which only
+// refers to them, with every Pokemon found. Both results are walked
+// from start to end.
+static void bench_views(void) {
+    printf("\n>> get_pokemon_of_type vs view_pokemon_of_type\n");
+    printf("    %10s %14s %14s\n", "pokemon", "copy us", "view us");
+
+    int i = 0;
+    while (i < N_SIZES) {
+        int size = sizes[i];
+        Pokedex pokedex = build_pokedex(size);
+        find_every_pokemon(pokedex);
+
+        double start = now_seconds();
+        Pokedex copies = get_pokemon_of_type(pokedex, NORMAL_TYPE);
+        long copy_checksum = 0;
+        int step = 0;
+        int matches = count_total_pokemon(copies);
+        while (step < matches) {
+            copy_checksum += pokemon_id(get_current_pokemon(copies));
+            next_pokemon(copies);
+            step += 1;
+        }
+        destroy_pokedex(copies);
+        double copy_elapsed = now_seconds() - start;
+
+        start = now_seconds();
+        PokedexView view = view_pokemon_of_type(pokedex, NORMAL_TYPE);
+        long view_checksum = 0;
+        step = 0;
+        matches = view_count(view);
+        while (step < matches) {
+            view_checksum += pokemon_id(view_current_pokemon(view));
+            view_next_pokemon(view);
+            step += 1;
+        }
+        destroy_view(view);
+        double view_elapsed = now_seconds() - start;
+        assert(copy_checksum == view_checksum);
+
+        printf("    %10d %14.1f %14.1f\n", size, copy_elapsed * 1e6,
+            view_elapsed * 1e6);
+        destroy_pokedex(pokedex);
+        i += 1;
+    }
+}
+
+// `bench_exploring` times go_exploring finding all but one of the
+// Pokemon in the Pokedex, in each exploring_mode. In EXPLORE_COMPATIBLE
+// mode the last draws rarely land on a Pokemon that is still unfound.
+static void bench_exploring(void) {
+    printf("\n>> go_exploring (find all but one)\n");
+    printf("    %10s %14s %14s\n", "pokemon", "sampled ns", "compat ns");
+
+    int i = 0;
+    while (i < N_SIZES) {
+        int size = sizes[i];
+
+        Pokedex pokedex = build_pokedex(size);
+        set_exploring_mode(pokedex, EXPLORE_SAMPLED);
+        double start = now_seconds();
+        go_exploring(pokedex, 1, size, size - 1);
+        double sampled_elapsed = now_seconds() - start;
+        assert(count_found_pokemon(pokedex) == size - 1);
+        destroy_pokedex(pokedex);
+
+        pokedex = build_pokedex(size);
+        start = now_seconds();
+        go_exploring(pokedex, 1, size, size - 1);
+        double compat_elapsed = now_seconds() - start;
+        assert(count_found_pokemon(pokedex) == size - 1);
+        destroy_pokedex(pokedex);
+
+        printf("    %10d %14.1f %14.1f\n", size, sampled_elapsed * 1e9 / size,
+            compat_elapsed * 1e9 / size);
+        i += 1;
+    }
+}
+
+// `bench_id_ranges` finds every Pokemon, then times view_found_pokemon
+// over the whole Pokedex and view_found_pokemon_in_range over windows
+// of 151 IDs spread through it.
+//
+// The cost per window should not grow much with the size of the Pokedex.
+static void bench_id_ranges(void) {
+    printf("\n>> view_found_pokemon / view_found_pokemon_in_range\n");
+    printf("    %10s %14s %14s\n", "pokemon", "all ns/each", "window us");
+
+    int windows = 1000;
+    int i = 0;
+    while (i < N_SIZES) {
+        int size = sizes[i];
+        Pokedex pokedex = build_pokedex(size);
+        find_every_pokemon(pokedex);
+
+        double start = now_seconds();
+        PokedexView view = view_found_pokemon(pokedex);
+        assert(view_count(view) == size);
+        destroy_view(view);
+        double all_elapsed = now_seconds() - start;
+
+        long checksum = 0;
+        start = now_seconds();
+        int window = 0;
+        while (window < windows) {
+            int min_id = (int) ((long) window * (size - 151) / windows);
+            view = view_found_pokemon_in_range(pokedex, min_id, min_id + 150);
+            checksum += view_count(view);
+            destroy_view(view);
+            window += 1;
+        }
+        double window_elapsed = now_seconds() - start;
+        assert(checksum == (long) windows * 151);
+
+        printf("    %10d %14.1f %14.2f\n", size, all_elapsed * 1e9 / size,
+            window_elapsed * 1e6 / windows);
+        destroy_pokedex(pokedex);
+        i += 1;
+    }
+}
+
+// `bench_snapshot` compares building an arena Pokedex one Pokemon at a
+// time (new_pokedex_pokemon, add_pokemon, find_current_pokemon and
+// add_pokemon_evolution) to loading the same Pokedex from a snapshot
+// with load_pokedex. Every other Pokemon is found and evolves into the
+// next one.
+static void bench_snapshot(void) {
+    printf("\n>> building vs load_pokedex (per Pokemon)\n");
+    printf("    %10s %14s %14s %14s\n", "pokemon", "build ns", "save ns",
+        "load ns");
+
+    char *path = "bench_pokedex_snapshot.bin";
+    int i = 0;
+    while (i < N_SIZES) {
+        int size = sizes[i];
+
+        double start = now_seconds();
+        Pokedex pokedex = new_arena_pokedex();
+        fill_pokedex(pokedex, size);
+        int id = 0;
+        while (id < size) {
+            if (id % 2 == 0) {
+                find_current_pokemon(pokedex);
+                if (id + 1 < size) {
+                    add_pokemon_evolution(pokedex, id, id + 1);
+                }
+            }
+            next_pokemon(pokedex);
+            id += 1;
+        }
+        double build_elapsed = now_seconds() - start;
+
+        start = now_seconds();
+        int saved = save_pokedex(pokedex, path);
+        double save_elapsed = now_seconds() - start;
+        assert(saved == 1);
+
+        start = now_seconds();
+        Pokedex loaded = load_pokedex(path);
+        double load_elapsed = now_seconds() - start;
+        assert(loaded != NULL);
+        assert(count_total_pokemon(loaded) == size);
+        assert(count_found_pokemon(loaded) == count_found_pokemon(pokedex));
+
+        printf("    %10d %14.1f %14.1f %14.1f\n", size, build_elapsed * 1e9 / size,
+            save_elapsed * 1e9 / size, load_elapsed * 1e9 / size);
+        destroy_pokedex(loaded);
+        destroy_pokedex(pokedex);
+        i += 1;
+    }
+    remove(path);
+}
+
+// `bench_import` compares importing a CSV file with a loop that reads
+// it one line at a time (fgets, pokemon_type_from_string,
+// new_pokedex_pokemon, add_pokemon and add_pokemon_evolution) to
+// import_pokedex, on one thread and on one thread per processor. Every
+// other Pokemon evolves into the next one.
+static void bench_import(void) {
+    printf("\n>> line by line vs import_pokedex (per Pokemon)\n");
+    printf("    %10s %14s %14s %14s\n", "pokemon", "loop ns", "1 thread ns",
+        "all threads ns");
+
+    char *path = "bench_pokedex_import.csv";
+    int i = 0;
+    while (i < N_SIZES) {
+        int size = sizes[i];
+        write_csv(path, size);
+
+        double start = now_seconds();
+        Pokedex looped = import_line_by_line(path);
+        double loop_elapsed = now_seconds() - start;
+        assert(count_total_pokemon(looped) == size);
+        destroy_pokedex(looped);
+
+        start = now_seconds();
+        Pokedex imported = import_pokedex(path, 1);
+        double one_elapsed = now_seconds() - start;
+        assert(imported != NULL && count_total_pokemon(imported) == size);
+        destroy_pokedex(imported);
+
+        start = now_seconds();
+        imported = import_pokedex(path, 0);
+        double all_elapsed = now_seconds() - start;
+        assert(imported != NULL && count_total_pokemon(imported) == size);
+        destroy_pokedex(imported);
+
+        printf("    %10d %14.1f %14.1f %14.1f\n", size, loop_elapsed * 1e9 / size,
+            one_elapsed * 1e9 / size, all_elapsed * 1e9 / size);
+        i += 1;
+    }
+    remove(path);
+}
+
+// `bench_type_lookup` compares pokemon_type_from_string to the linear
+// strcasecmp scan over every type name it replaced, for a type near the
+// start of the table, one at the end, one in capitals and a string that
+// is not a type at all.
+static void bench_type_lookup(void) {
+    printf("\n>> pokemon_type_from_string (per call)\n");
+    printf("    %10s %14s %14s\n", "string", "linear ns", "hashed ns");
+
+    char *strings[] = {"Fire", "Fairy", "ELECTRIC", "Unknown"};
+    int calls = 10000000;
+    int i = 0;
+    while (i < (int) (sizeof(strings) / sizeof(strings[0]))) {
+        // Copies the string each time so the compiler cannot hoist the
+        // lookup out of the loop
+        char text[MAX_NAME_LENGTH];
+        strcpy(text, strings[i]);
+        char *volatile string = text;
+
+        double start = now_seconds();
+        long linear_sum = 0;
+        int call = 0;
+        while (call < calls) {
+            linear_sum += linear_type_from_string(string);
+            call += 1;
+        }
+        double linear_elapsed = now_seconds() - start;
+
+        start = now_seconds();
+        long hashed_sum = 0;
+        call = 0;
+        while (call < calls) {
+            hashed_sum += pokemon_type_from_string(string);
+            call += 1;
+        }
+        double hashed_elapsed = now_seconds() - start;
+        assert(linear_sum == hashed_sum);
+
+        printf("    %10s %14.2f %14.2f\n", strings[i],
+            linear_elapsed * 1e9 / calls, hashed_elapsed * 1e9 / calls);
+        i += 1;
+    }
+}
+
+// `bench_accessors` scans every Pokemon in a Pokedex, reading each one's
+// pokemon_id, first type and weight, once with the checked accessors
+// and once with the accessors as this file was built. The second column
+// is only faster when built with POKEMON_UNCHECKED (or NDEBUG), which
+// makes the accessors inline reads of the Pokemon (see pokemon.h).
+static void bench_accessors(void) {
+    printf("\n>> checked vs unchecked accessors (per Pokemon scanned)\n");
+    printf("    %10s %14s %14s\n", "pokemon", "checked ns", "as built ns");
+
+    int i = 0;
+    while (i < N_SIZES) {
+        int size = sizes[i];
+        Pokedex pokedex = new_arena_pokedex();
+        fill_pokedex(pokedex, size);
+        Pokemon *pokemon = malloc(size * sizeof(Pokemon));
+        assert(pokemon != NULL);
+        int j = 0;
+        while (j < size) {
+            pokemon[j] = get_current_pokemon(pokedex);
+            next_pokemon(pokedex);
+            j += 1;
+        }
+        int scans = 100000000 / size;
+
+        double start = now_seconds();
+        double checked_sum = 0;
+        int scan = 0;
+        while (scan < scans) {
+            j = 0;
+            while (j < size) {
+                checked_sum += (pokemon_id)(pokemon[j]) +
+                    (pokemon_first_type)(pokemon[j]) + (pokemon_weight)(pokemon[j]);
+                j += 1;
+            }
+            scan += 1;
+        }
+        double checked_elapsed = now_seconds() - start;
+
+        start = now_seconds();
+        double built_sum = 0;
+        scan = 0;
+        while (scan < scans) {
+            j = 0;
+            while (j < size) {
+                built_sum += pokemon_id(pokemon[j]) +
+                    pokemon_first_type(pokemon[j]) + pokemon_weight(pokemon[j]);
+                j += 1;
+            }
+            scan += 1;
+        }
+        double built_elapsed = now_seconds() - start;
+        assert(checked_sum == built_sum);
+
+        long scanned = (long) scans * size;
+        printf("    %10d %14.2f %14.2f\n", size, checked_elapsed * 1e9 / scanned,
+            built_elapsed * 1e9 / scanned);
+        free(pokemon);
+        destroy_pokedex(pokedex);
+        i += 1;
+    }
+}
+
+// `bench_compact` scans every Pokemon of a Pokedex, adding up each one's
+// height, weight and first type, once through an array of its Pokemon
+// and once through the array of compact records made by pack_pokedex.
+static void bench_compact(void) {
+    printf("\n>> Pokemon vs compact records (per Pokemon scanned)\n");
+    printf("    %10s %14s %14s %14s\n", "pokemon", "pokemon ns", "compact ns",
+        "pack ns");
+
+    int i = 0;
+    while (i < N_SIZES) {
+        int size = sizes[i];
+        Pokedex pokedex = build_pokedex(size);
+        Pokemon *pokemon = malloc(size * sizeof(Pokemon));
+        assert(pokemon != NULL);
+        int j = 0;
+        while (j < size) {
+            pokemon[j] = get_current_pokemon(pokedex);
+            next_pokemon(pokedex);
+            j += 1;
+        }
+
+        double start = now_seconds();
+        CompactPokemon *records = NULL;
+        int n_records = pack_pokedex(pokedex, &records);
+        double pack_elapsed = now_seconds() - start;
+        assert(n_records == size);
+        int scans = 100000000 / size;
+
+        start = now_seconds();
+        double pokemon_sum = 0;
+        int scan = 0;
+        while (scan < scans) {
+            j = 0;
+            while (j < size) {
+                pokemon_sum += pokemon_height(pokemon[j]) +
+                    pokemon_weight(pokemon[j]) + pokemon_first_type(pokemon[j]);
+                j += 1;
+            }
+            scan += 1;
+        }
+        double pokemon_elapsed = now_seconds() - start;
+
+        start = now_seconds();
+        double compact_sum = 0;
+        scan = 0;
+        while (scan < scans) {
+            j = 0;
+            while (j < size) {
+                compact_sum += compact_pokemon_height(&records[j]) +
+                    compact_pokemon_weight(&records[j]) +
+                    compact_pokemon_first_type(&records[j]);
+                j += 1;
+            }
+            scan += 1;
+        }
+        double compact_elapsed = now_seconds() - start;
+        assert(pokemon_sum == compact_sum);
+
+        long scanned = (long) scans * size;
+        printf("    %10d %14.2f %14.2f %14.1f\n", size,
+            pokemon_elapsed * 1e9 / scanned, compact_elapsed * 1e9 / scanned,
+            pack_elapsed * 1e9 / size);
+        free(records);
+        free(pokemon);
+        destroy_pokedex(pokedex);
+        i += 1;
+    }
+}
+
+// `bench_concurrent` serves a stream of requests to a Pokedex of 10000
+// found Pokemon from 1 to MAX_BENCH_THREADS threads. Of every 100
+// requests 1 adds a Pokemon, 10 are get_pokemon_of_type calls, and the
+// rest are split between search_pokemon and count_total_pokemon. The requests go
+// either to a new_pokedex Pokedex behind one mutex, or straight to a
+// new_concurrent_pokedex Pokedex, whose readers do not wait for each
+// other. The time is per request, so it should fall as threads are
+// added (up to the number of processors) when readers run in parallel.
+static void bench_concurrent(void) {
+    printf("\n>> one mutex vs concurrent Pokedex (per request)\n");
+    printf("    %10s %14s %14s\n", "threads", "mutex ns", "concurrent ns");
+
+    int size = 10000;
+    int n_ops = 20000;
+    int n_threads = 1;
+    while (n_threads <= MAX_BENCH_THREADS) {
+        pthread_mutex_t mutex;
+        pthread_mutex_init(&mutex, NULL);
+        Pokedex pokedex = build_pokedex(size);
+        find_every_pokemon(pokedex);
+        double mutex_elapsed = run_workers(pokedex, &mutex, n_threads, n_ops);
+        destroy_pokedex(pokedex);
+        pthread_mutex_destroy(&mutex);
+
+        pokedex = new_concurrent_pokedex();
+        fill_pokedex(pokedex, size);
+        find_every_pokemon(pokedex);
+        double concurrent_elapsed = run_workers(pokedex, NULL, n_threads, n_ops);
+        destroy_pokedex(pokedex);
+
+        printf("    %10d %14.1f %14.1f\n", n_threads,
+            mutex_elapsed * 1e9 / n_ops, concurrent_elapsed * 1e9 / n_ops);
+        n_threads *= 2;
+    }
+}
+
+// `bench_sharded` times an ingest of 64000 Pokemon split between 1 to
+// MAX_BENCH_THREADS threads: each Pokemon is created, added and found
+// by pokemon_id, and every fourth one is then removed. It is run on a
+// ShardedPokedex with one shard, where every write waits for every
+// other, and on one with four shards per processor. The time is per
+// Pokemon, so with enough shards it should fall as threads are added
+// (up to the number of processors).
+static void bench_sharded(void) {
+    printf("\n>> one shard vs sharded Pokedex ingest (per Pokemon)\n");
+    printf("    %10s %14s %14s\n", "threads", "1 shard ns", "sharded ns");
+
+    int n_pokemon = 64000;
+    int n_threads = 1;
+    while (n_threads <= MAX_BENCH_THREADS) {
+        ShardedPokedex sharded = new_sharded_pokedex(1);
+        double one_elapsed = run_ingest(sharded, n_threads, n_pokemon);
+        assert(sharded_count_total_pokemon(sharded) == n_pokemon * 3 / 4);
+        destroy_sharded_pokedex(sharded);
+
+        sharded = new_sharded_pokedex(0);
+        double sharded_elapsed = run_ingest(sharded, n_threads, n_pokemon);
+        assert(sharded_count_found_pokemon(sharded) == n_pokemon * 3 / 4);
+        destroy_sharded_pokedex(sharded);
+
+        printf("    %10d %14.1f %14.1f\n", n_threads,
+            one_elapsed * 1e9 / n_pokemon, sharded_elapsed * 1e9 / n_pokemon);
+        n_threads *= 2;
+    }
+}
+
+// `bench_parallel_queries` times view_pokemon_of_type and
+// view_search_pokemon on a Pokedex of 1000000 found Pokemon, with the
+// queries split across 1 to MAX_BENCH_THREADS threads of the Pokedex's
+// own task pool (see set_pool_threads). The search is for a single letter, so most names
+// are candidates. With more than one processor the times should fall
+// as threads are added, up to the number of processors.
+static void bench_parallel_queries(void) {
+    printf("\n>> Stage 5 queries split across threads (per query)\n");
+    printf("    %10s %14s %14s\n", "threads", "type us", "search us");
+
+    int size = 1000000;
+    int rounds = 10;
+    Pokedex pokedex = new_pokedex();
+    char name[MAX_NAME_LENGTH];
+    int id = 0;
+    while (id < size) {
+        make_search_name(id, name);
+        add_pokemon(pokedex, new_pokedex_pokemon(pokedex, id, name, 1.0,
+            10.0, (pokemon_type) (NORMAL_TYPE + id % (MAX_TYPE - NORMAL_TYPE)),
+            NONE_TYPE));
+        id += 1;
+    }
+    find_every_pokemon(pokedex);
+    destroy_view(view_search_pokemon(pokedex, "a"));
+
+    int n_threads = 1;
+    while (n_threads <= MAX_BENCH_THREADS) {
+        set_pool_threads(pokedex, n_threads);
+        double type_elapsed = 0;
+        double search_elapsed = 0;
+        int round = 0;
+        while (round < rounds) {
+            double start = now_seconds();
+            destroy_view(view_pokemon_of_either_type(pokedex, NORMAL_TYPE,
+                WATER_TYPE));
+            type_elapsed += now_seconds() - start;
+
+            start = now_seconds();
+            destroy_view(view_search_pokemon(pokedex, "e"));
+            search_elapsed += now_seconds() - start;
+            round += 1;
+        }
+        printf("    %10d %14.1f %14.1f\n", n_threads,
+            type_elapsed * 1e6 / rounds, search_elapsed * 1e6 / rounds);
+        n_threads *= 2;
+    }
+    destroy_pokedex(pokedex);
+}
+
+// `bench_evolutions` finds the Pokemon that evolves into each of 100
+// Pokemon in Pokedexes where every Pokemon is in a chain of three, with
+// get_prev_evolution and by checking the evolution of every Pokemon in
+// the Pokedex. get_prev_evolution should not depend on the size of the
+// Pokedex, while the scan grows with it.
+static void bench_evolutions(void) {
+    printf("\n>> get_prev_evolution vs scanning every evolution (per query)\n");
+    printf("    %10s %14s %14s\n", "size", "prev ns", "scan ns");
+
+    int n_queries = 100;
+    int s = 0;
+    while (s < 3) {
+        int size = sizes[s];
+        Pokedex pokedex = build_pokedex(size);
+        int id = 0;
+        while (id < size) {
+            if (id % 3 != 2 && id + 1 < size) {
+                add_pokemon_evolution(pokedex, id, id + 1);
+            }
+            id += 1;
+        }
+
+        int step = size / n_queries;
+        int checksum = 0;
+        double start = now_seconds();
+        int i = 0;
+        while (i < n_queries) {
+            change_current_pokemon(pokedex, i * step);
+            checksum += get_prev_evolution(pokedex);
+            i += 1;
+        }
+        double prev_elapsed = now_seconds() - start;
+
+        start = now_seconds();
+        i = 0;
+        while (i < n_queries) {
+            checksum -= linear_prev_evolution(pokedex, i * step);
+            i += 1;
+        }
+        double scan_elapsed = now_seconds() - start;
+        assert(checksum == 0);
+
+        printf("    %10d %14.1f %14.1f\n", size,
+            prev_elapsed * 1e9 / n_queries, scan_elapsed * 1e9 / n_queries);
+        destroy_pokedex(pokedex);
+        s += 1;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+//                     Helper Functions                               //
+////////////////////////////////////////////////////////////////////////
+
+// Creates a Pokedex containing Pokemon with IDs 0 to size - 1, added in
+// order of ID.
+static Pokedex build_pokedex(int size) {
+    Pokedex pokedex = new_pokedex();
+    fill_pokedex(pokedex, size);
+    return pokedex;
+}
+
+// Adds Pokemon with IDs 0 to size - 1 to an empty Pokedex, in order of
+// ID, creating them with new_pokedex_pokemon.
+static void fill_pokedex(Pokedex pokedex, int size) {
+    char name[MAX_NAME_LENGTH];
+    int id = 0;
+    while (id < size) {
+        make_name(id, name);
+        add_pokemon(pokedex, new_pokedex_pokemon(pokedex, id, name, 1.0,
+            10.0, (pokemon_type) (NORMAL_TYPE + id % (MAX_TYPE - NORMAL_TYPE)),
+            NONE_TYPE));
+        id += 1;
+    }
+}
+
+// Writes a CSV file (with a header) of Pokemon with IDs 0 to size - 1,
+// where every other Pokemon evolves into the next one.
+static void write_csv(char *path, int size) {
+    FILE *file = fopen(path, "w");
+    assert(file != NULL);
+    fprintf(file, "pokemon_id,name,height,weight,type1,type2,evolution_id\n");
+    char name[MAX_NAME_LENGTH];
+    int id = 0;
+    while (id < size) {
+        make_name(id, name);
+        pokemon_type type = NORMAL_TYPE + id % (MAX_TYPE - NORMAL_TYPE);
+        fprintf(file, "%d,%s,1.0,10.0,%s,None,", id, name,
+            pokemon_type_to_string(type));
+        if (id % 2 == 0 && id + 1 < size) {
+            fprintf(file, "%d", id + 1);
+        }
+        fprintf(file, "\n");
+        id += 1;
+    }
+    fclose(file);
+}
+
+// Imports a CSV file written by write_csv the way it would be done
+// without import_pokedex: one line at a time, adding each Pokemon as it
+// is read and the evolutions once every Pokemon is in.
+static Pokedex import_line_by_line(char *path) {
+    FILE *file = fopen(path, "r");
+    assert(file != NULL);
+    Pokedex pokedex = new_arena_pokedex();
+    int capacity = 1024;
+    int n_evolutions = 0;
+    int *evolutions = malloc(capacity * 2 * sizeof(int));
+    assert(evolutions != NULL);
+    char line[256];
+    char *header = fgets(line, sizeof(line), file);
+    assert(header != NULL);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        int id = atoi(strtok(line, ","));
+        char *name = strtok(NULL, ",");
+        double height = atof(strtok(NULL, ","));
+        double weight = atof(strtok(NULL, ","));
+        pokemon_type type1 = pokemon_type_from_string(strtok(NULL, ","));
+        pokemon_type type2 = pokemon_type_from_string(strtok(NULL, ",\n"));
+        char *evolution = strtok(NULL, ",\n");
+        add_pokemon(pokedex, new_pokedex_pokemon(pokedex, id, name, height,
+            weight, type1, type2));
+        if (evolution != NULL) {
+            if (n_evolutions == capacity) {
+                capacity *= 2;
+                evolutions = realloc(evolutions, capacity * 2 * sizeof(int));
+                assert(evolutions != NULL);
+            }
+            evolutions[n_evolutions * 2] = id;
+            evolutions[n_evolutions * 2 + 1] = atoi(evolution);
+            n_evolutions += 1;
+        }
+    }
+    fclose(file);
+    int i = 0;
+    while (i < n_evolutions) {
+        add_pokemon_evolution(pokedex, evolutions[i * 2], evolutions[i * 2 + 1]);
+        i += 1;
+    }
+    free(evolutions);
+    return pokedex;
+}
+
+// Finds the type named `text` (ignoring case) by comparing it with each
+// type name in turn, as pokemon_type_from_string used to.
+static pokemon_type linear_type_from_string(char *text) {
+    pokemon_type type = NONE_TYPE;
+    while (type < MAX_TYPE) {
+        if (strcasecmp(pokemon_type_to_string(type), text) == 0) {
+            return type;
+        }
+        type += 1;
+    }
+    return INVALID_TYPE;
+}
+
+// Writes a valid Pokemon name derived from `id` (one letter per digit).
+static void make_name(int id, char *name) {
+    int i = 0;
+    name[i] = 'P';
+    i += 1;
+    do {
+        name[i] = 'a' + id % 10;
+        id /= 10;
+        i += 1;
+    } while (id > 0 && i < MAX_NAME_LENGTH - 1);
+    name[i] = '\0';
+}
+
+// Writes a valid Pokemon name of 5 to 10 letters drawn from `id`, which
+// spreads the names over the whole alphabet like real names are.
+static void make_search_name(int id, char *name) {
+    unsigned int state = (unsigned int) id * 2654435761u + 12345;
+    int length = 5 + state % 6;
+    int i = 0;
+    while (i < length) {
+        state = state * 1103515245u + 12345;
+        name[i] = 'a' + (state >> 16) % 26;
+        i += 1;
+    }
+    name[0] = name[0] - 'a' + 'A';
+    name[i] = '\0';
+}
+
+// Sets every Pokemon in the Pokedex to be found, leaving the last one
+// selected.
+static void find_every_pokemon(Pokedex pokedex) {
+    int total = count_total_pokemon(pokedex);
+    int step = 0;
+    while (step < total) {
+        find_current_pokemon(pokedex);
+        next_pokemon(pokedex);
+        step += 1;
+    }
+}
+
+// Finds the first Pokemon that evolves into the Pokemon with pokemon_id
+// = id by checking the evolution of every Pokemon in the Pokedex, as
+// get_prev_evolution would without its lists of earlier evolutions.
+static int linear_prev_evolution(Pokedex pokedex, int id) {
+    int total = count_total_pokemon(pokedex);
+    change_current_pokemon(pokedex, 0);
+    int prev = NO_PRE_EVOLUTION;
+    int step = 0;
+    while (prev == NO_PRE_EVOLUTION && step < total) {
+        if (get_next_evolution(pokedex) == id) {
+            prev = pokemon_id(get_current_pokemon(pokedex));
+        }
+        next_pokemon(pokedex);
+        step += 1;
+    }
+    return prev;
+}
+
+// Counts the Pokemon with `text` in their name by checking every Pokemon
+// in the Pokedex, as search_pokemon would without its name index.
+static int linear_search_count(Pokedex pokedex, char *text) {
+    int text_length = strlen(text);
+    int count = 0;
+    change_current_pokemon(pokedex, 0);
+    int step = 0;
+    int total = count_total_pokemon(pokedex);
+    while (step < total) {
+        char *name = pokemon_name(get_current_pokemon(pokedex));
+        int start = 0;
+        int matched = 0;
+        while (matched == 0 && name[start] != '\0') {
+            int j = 0;
+            while (j < text_length && name[start + j] != '\0' &&
+                (name[start + j] | 0x20) == (text[j] | 0x20)) {
+                j += 1;
+            }
+            if (j == text_length) {
+                matched = 1;
+            }
+            start += 1;
+        }
+        count += matched;
+        next_pokemon(pokedex);
+        step += 1;
+    }
+    return count;
+}
+
+// Splits `n_ops` requests to the Pokedex between `n_threads` threads
+// running serve_requests, returning how long they took in seconds.
+static double run_workers(Pokedex pokedex, pthread_mutex_t *mutex,
+    int n_threads, int n_ops) {
+
+    pthread_t threads[MAX_BENCH_THREADS];
+    struct bench_worker workers[MAX_BENCH_THREADS];
+    int first_id = count_total_pokemon(pokedex);
+    double start = now_seconds();
+    int i = 0;
+    while (i < n_threads) {
+        workers[i].pokedex = pokedex;
+        workers[i].mutex = mutex;
+        workers[i].n_ops = n_ops / n_threads;
+        workers[i].first_id = first_id + i * workers[i].n_ops;
+        int created = pthread_create(&threads[i], NULL, serve_requests,
+            &workers[i]);
+        assert(created == 0);
+        i += 1;
+    }
+    i = 0;
+    while (i < n_threads) {
+        pthread_join(threads[i], NULL);
+        i += 1;
+    }
+    return now_seconds() - start;
+}
+
+// Makes the requests of one bench_concurrent thread.
+static void *serve_requests(void *worker) {
+    struct bench_worker *w = worker;
+    char name[MAX_NAME_LENGTH];
+    long checksum = 0;
+    int op = 0;
+    while (op < w->n_ops) {
+        if (w->mutex != NULL) {
+            pthread_mutex_lock(w->mutex);
+        }
+        if (op % 100 == 0) {
+            make_name(w->first_id + op, name);
+            add_pokemon(w->pokedex, new_pokedex_pokemon(w->pokedex,
+                w->first_id + op, name, 1.0, 10.0, NORMAL_TYPE, NONE_TYPE));
+        } else if (op % 10 == 1) {
+            Pokedex results = get_pokemon_of_type(w->pokedex,
+                (pokemon_type) (NORMAL_TYPE + op % (MAX_TYPE - NORMAL_TYPE)));
+            checksum += count_total_pokemon(results);
+            destroy_pokedex(results);
+        } else if (op % 2 == 0) {
+            // Three letters of a name, which match a few dozen Pokemon
+            make_name(op, name);
+            name[4] = '\0';
+            Pokedex results = search_pokemon(w->pokedex, name + 1);
+            checksum += count_total_pokemon(results);
+            destroy_pokedex(results);
+        } else {
+            checksum += count_total_pokemon(w->pokedex);
+        }
+        if (w->mutex != NULL) {
+            pthread_mutex_unlock(w->mutex);
+        }
+        op += 1;
+    }
+    assert(checksum > 0);
+    return NULL;
+}
+
+// Splits an ingest of `n_pokemon` Pokemon between `n_threads` threads
+// running ingest_pokemon, returning how long they took in seconds.
+static double run_ingest(ShardedPokedex sharded, int n_threads, int n_pokemon) {
+    pthread_t threads[MAX_BENCH_THREADS];
+    struct sharded_worker workers[MAX_BENCH_THREADS];
+    double start = now_seconds();
+    int i = 0;
+    while (i < n_threads) {
+        workers[i].sharded = sharded;
+        workers[i].n_pokemon = n_pokemon / n_threads;
+        workers[i].first_id = i * workers[i].n_pokemon;
+        int created = pthread_create(&threads[i], NULL, ingest_pokemon,
+            &workers[i]);
+        assert(created == 0);
+        i += 1;
+    }
+    i = 0;
+    while (i < n_threads) {
+        pthread_join(threads[i], NULL);
+        i += 1;
+    }
+    return now_seconds() - start;
+}
+
+// Ingests the Pokemon of one bench_sharded thread.
+static void *ingest_pokemon(void *worker) {
+    struct sharded_worker *w = worker;
+    char name[MAX_NAME_LENGTH];
+    int id = w->first_id;
+    while (id < w->first_id + w->n_pokemon) {
+        make_name(id, name);
+        sharded_add_pokemon(w->sharded, new_sharded_pokemon(w->sharded, id,
+            name, 1.0, 10.0, NORMAL_TYPE, NONE_TYPE));
+        int found = sharded_find_pokemon(w->sharded, id);
+        assert(found);
+        if (id % 4 == 3) {
+            int removed = sharded_remove_pokemon(w->sharded, id);
+            assert(removed);
+        }
+        id += 1;
+    }
+    return NULL;
+}
+
+// Returns a monotonic timestamp in seconds.
+static double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+// Compact fixed-size records of Pokemon
+//
+// A height or weight is only packed when its number of tenths, divided
+// by 10 again, gives back exactly the same double. Dividing a whole
+// number of tenths by 10.0 gives the closest double to that decimal,
+// which is the double a decimal like 0.7 becomes in source or through
+// strtod, so every measure given to one decimal place packs.
+
+#include <string.h>
+
+#include "compact_pokemon.h"
+
+_Static_assert(sizeof(CompactPokemon) == 32, "CompactPokemon must be 32 bytes");
+
+static int to_tenths(double measure, uint16_t *tenths);
+
+// Packs the Pokemon, returning 0 if any attribute does not fit
+int pack_pokemon(Pokemon pokemon, CompactPokemon *packed) {
+    char *name = pokemon_name(pokemon);
+    size_t length = strlen(name);
+    uint16_t height = 0;
+    uint16_t weight = 0;
+    if (length >= COMPACT_NAME_SIZE ||
+        !to_tenths(pokemon_height(pokemon), &height) ||
+        !to_tenths(pokemon_weight(pokemon), &weight)) {
+        return 0;
+    }
+
+    packed->pokemon_id = pokemon_id(pokemon);
+    packed->height = height;
+    packed->weight = weight;
+    packed->type1 = pokemon_first_type(pokemon);
+    packed->type2 = pokemon_second_type(pokemon);
+    memset(packed->name, '\0', COMPACT_NAME_SIZE);
+    memcpy(packed->name, name, length);
+    return 1;
+}
+
+Pokemon unpack_pokemon(CompactPokemon *packed) {
+    return new_pokemon(packed->pokemon_id, packed->name,
+        compact_pokemon_height(packed), compact_pokemon_weight(packed),
+        compact_pokemon_first_type(packed), compact_pokemon_second_type(packed));
+}
+
+// Sets the number of tenths in the measure, returning 0 if the measure
+// is out of range or not exactly a whole number of tenths
+static int to_tenths(double measure, uint16_t *tenths) {
+    // Written so that NaN is out of range too
+    if (!(measure >= 0 && measure <= COMPACT_MAX_MEASURE)) {
+        return 0;
+    }
+    uint16_t rounded = (uint16_t) (measure * 10 + 0.5);
+    if (rounded / 10.0 != measure) {
+        return 0;
+    }
+    *tenths = rounded;
+    return 1;
+}
\ No newline at end of file
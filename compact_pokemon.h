@@ -0,0 +1,65 @@
+// Compact fixed-size records of Pokemon
+
+#include <stdint.h>
+
+#include "pokemon.h"
+
+#ifndef _COMPACT_POKEMON_H_
+#define _COMPACT_POKEMON_H_
+
+// Names of up to COMPACT_NAME_SIZE - 1 characters fit in a record.
+#define COMPACT_NAME_SIZE 22
+
+// The largest height or weight a record can hold.
+#define COMPACT_MAX_MEASURE 6553.5
+
+// A Pokemon packed into 32 bytes, so that a million of them take 32MB
+// in one array with no pointers to follow.
+//
+// Heights and weights are stored in tenths of a metre or kilogram
+// (which is all detail_pokemon prints), the types in a byte each, and
+// the name in the record itself.
+//
+// Unlike a Pokemon, a record can be read directly, or with the inline
+// functions below, which give the same values as the matching Pokemon
+// functions would.
+typedef struct compact_pokemon {
+    int32_t  pokemon_id;
+    uint16_t height; // In tenths of a metre
+    uint16_t weight; // In tenths of a kilogram
+    uint8_t  type1;
+    uint8_t  type2;
+    char     name[COMPACT_NAME_SIZE]; // Padded with '\0'
+} CompactPokemon;
+
+// Pack the Pokemon into `packed`, if that can be done without losing
+// anything.
+//
+// Returns 1 if the Pokemon was packed, or 0 (leaving `packed` alone) if
+// its name has COMPACT_NAME_SIZE or more characters, or its height or
+// weight is negative, more than COMPACT_MAX_MEASURE or not a whole
+// number of tenths.
+int pack_pokemon(Pokemon pokemon, CompactPokemon *packed);
+
+// Create a new Pokemon (see new_pokemon in pokemon.h) from a record
+// made by pack_pokemon, with exactly the attributes of the Pokemon that
+// was packed.
+Pokemon unpack_pokemon(CompactPokemon *packed);
+
+static inline double compact_pokemon_height(CompactPokemon *packed) {
+    return packed->height / 10.0;
+}
+
+static inline double compact_pokemon_weight(CompactPokemon *packed) {
+    return packed->weight / 10.0;
+}
+
+static inline pokemon_type compact_pokemon_first_type(CompactPokemon *packed) {
+    return (pokemon_type) packed->type1;
+}
+
+static inline pokemon_type compact_pokemon_second_type(CompactPokemon *packed) {
+    return (pokemon_type) packed->type2;
+}
+
+#endif // _COMPACT_POKEMON_H_
\ No newline at end of file
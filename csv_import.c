@@ -0,0 +1,695 @@
+// Bulk import of Pokemon from CSV or TSV files
+//
+// The file is read a chunk at a time. Each chunk is cut at line breaks
+// into one piece per thread, and the pieces are run as tasks on the
+// process-wide task pool, each splitting its lines into fields in place
+// and checking them, without touching the Pokedex. The calling thread
+// then turns the records into Pokemon in file order. Once
+// the whole file is read the pokemon_ids are sorted once to find any
+// duplicates, and everything is added in bulk.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "csv_import.h"
+#include "task_pool.h"
+
+#define CHUNK_SIZE (4 << 20)
+#define MIN_PIECE_SIZE (64 << 10)
+#define MAX_PIECES 64
+#define N_FIELDS 7
+#define NO_EVOLUTION (-1)
+#define MAX_EXACT_DIGITS 15
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+
+// One line of the file, checked but not yet made into a Pokemon
+struct import_record {
+    int id;
+    char *name; // Points into the chunk
+    double height;
+    double weight;
+    pokemon_type type1;
+    pokemon_type type2;
+    int evolution_id;
+    int line;   // Line in the piece, from 1
+};
+
+// The lines of one piece of a chunk, parsed by one task
+struct parse_job {
+    char *start;
+    char *end;
+    char delimiter;
+    struct import_record *records;
+    int n_records;
+    int capacity;
+    int n_lines;       // Lines in the piece
+    int error_line;    // Line in the piece of the first error, 0 if none
+    const char *error;
+};
+
+// Everything read so far, in file order
+struct import_state {
+    Pokedex pokedex;
+    Pokemon *pokemon;
+    int *lines;
+    int *evolution_ids;
+    int n_pokemon;
+    int capacity;
+};
+
+// A pokemon_id with where it is in the file, for finding duplicates
+// and following evolutions
+struct id_and_line {
+    int id;
+    int line;
+    int index; // Which Pokemon of the file it is
+};
+
+static int read_chunk(FILE *file, char **buffer, size_t *size, size_t *length,
+    int *at_end);
+static char detect_delimiter(char *start, char *end);
+static char *skip_header(char *start, char *end);
+static int split_chunk(char *start, char *end, char delimiter, int n_threads,
+    struct parse_job *jobs);
+static void parse_piece(void *jobs, int piece);
+static const char *parse_line(char *line, char delimiter,
+    struct import_record *record);
+static int blank_line(char *line);
+static char *trim_field(char *field);
+static int parse_int(char *field, int *value);
+static int parse_double(char *field, double *value);
+static void add_records(struct import_state *state, struct parse_job *job,
+    int first_line);
+static const char *check_ids(struct import_state *state, int *error_line);
+static void sort_ids(struct id_and_line *ids, int n_ids);
+static int find_id(struct id_and_line *ids, int n_ids, int id);
+static int find_cycle(int *next, int n);
+static void free_jobs(struct parse_job *jobs, int n_jobs);
+static void free_state(struct import_state *state);
+
+// Reads and parses the file a chunk at a time, then builds the Pokedex
+Pokedex import_pokedex(char *path, int n_threads) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "%s: cannot open file\n", path);
+        return NULL;
+    }
+    if (n_threads <= 0) {
+        n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (n_threads < 1) {
+        n_threads = 1;
+    } else if (n_threads > MAX_PIECES) {
+        n_threads = MAX_PIECES;
+    }
+
+    struct import_state state;
+    state.pokedex = new_arena_pokedex();
+    state.pokemon = NULL;
+    state.lines = NULL;
+    state.evolution_ids = NULL;
+    state.n_pokemon = 0;
+    state.capacity = 0;
+
+    size_t size = CHUNK_SIZE;
+    char *buffer = malloc(size + 1);
+    assert(buffer != NULL);
+    size_t length = 0;
+    int at_end = 0;
+    int first_chunk = 1;
+    char delimiter = ',';
+    int lines_before = 0; // Lines in the chunks already parsed
+    struct parse_job jobs[MAX_PIECES];
+
+    while (!at_end || length > 0) {
+        if (!read_chunk(file, &buffer, &size, &length, &at_end)) {
+            fprintf(stderr, "%s: cannot read file\n", path);
+            fclose(file);
+            free(buffer);
+            free_state(&state);
+            return NULL;
+        }
+        // Only whole lines are parsed, the rest waits for the next chunk
+        char *start = buffer;
+        char *end = buffer + length;
+        if (!at_end) {
+            while (end > start && end[-1] != '\n') {
+                end -= 1;
+            }
+            if (end == start) {
+                // Not even one whole line yet, so read more
+                continue;
+            }
+        }
+        if (first_chunk) {
+            delimiter = detect_delimiter(start, end);
+            char *after_header = skip_header(start, end);
+            if (after_header != start) {
+                lines_before += 1;
+            }
+            start = after_header;
+            first_chunk = 0;
+        }
+
+        int n_jobs = split_chunk(start, end, delimiter, n_threads, jobs);
+        if (n_jobs == 1) {
+            parse_piece(jobs, 0);
+        } else {
+            task_pool_run(default_task_pool(), n_jobs, parse_piece, jobs);
+        }
+
+        // Makes Pokemon from the pieces in file order, stopping at the
+        // first error
+        int i = 0;
+        while (i < n_jobs) {
+            if (jobs[i].error != NULL) {
+                fprintf(stderr, "%s:%d: %s\n", path,
+                    lines_before + jobs[i].error_line, jobs[i].error);
+                fclose(file);
+                free(buffer);
+                free_jobs(jobs, n_jobs);
+                free_state(&state);
+                return NULL;
+            }
+            add_records(&state, &jobs[i], lines_before);
+            lines_before += jobs[i].n_lines;
+            i += 1;
+        }
+        free_jobs(jobs, n_jobs);
+
+        // Keeps the partial line at the end for the next chunk
+        length = buffer + length - end;
+        memmove(buffer, end, length);
+    }
+    fclose(file);
+    free(buffer);
+
+    int error_line = 0;
+    const char *error = check_ids(&state, &error_line);
+    if (error != NULL) {
+        fprintf(stderr, "%s:%d: %s\n", path, error_line, error);
+        free_state(&state);
+        return NULL;
+    }
+
+    Pokedex pokedex = state.pokedex;
+    add_pokemon_bulk(pokedex, state.pokemon, state.n_pokemon);
+    int i = 0;
+    while (i < state.n_pokemon) {
+        if (state.evolution_ids[i] != NO_EVOLUTION) {
+            add_pokemon_evolution(pokedex, pokemon_id(state.pokemon[i]),
+                state.evolution_ids[i]);
+        }
+        i += 1;
+    }
+    state.pokedex = NULL;
+    free_state(&state);
+    return pokedex;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//                         [EXTRA FUNCTIONS]                          //
+////////////////////////////////////////////////////////////////////////
+
+// Fills the buffer after the `length` bytes already in it, doubling it
+// first if it is full. Returns 0 if the file could not be read.
+static int read_chunk(FILE *file, char **buffer, size_t *size, size_t *length,
+    int *at_end) {
+
+    if (*length == *size) {
+        *size *= 2;
+        *buffer = realloc(*buffer, *size + 1);
+        assert(*buffer != NULL);
+    }
+    size_t wanted = *size - *length;
+    size_t n_read = fread(*buffer + *length, 1, wanted, file);
+    *length += n_read;
+    if (n_read < wanted) {
+        if (ferror(file)) {
+            return 0;
+        }
+        *at_end = 1;
+    }
+    return 1;
+}
+
+// Returns '\t' if the first line has a tab in it, ',' otherwise
+static char detect_delimiter(char *start, char *end) {
+    char *c = start;
+    while (c < end && *c != '\n') {
+        if (*c == '\t') {
+            return '\t';
+        }
+        c += 1;
+    }
+    return ',';
+}
+
+// Returns where the lines after the header start, or `start` if the
+// first line is not a header (i.e. its first field is a number)
+static char *skip_header(char *start, char *end) {
+    char *c = start;
+    while (c < end && (*c == ' ' || *c == '"')) {
+        c += 1;
+    }
+    if (c < end && (*c >= '0' && *c <= '9')) {
+        return start;
+    }
+    while (c < end && *c != '\n') {
+        c += 1;
+    }
+    if (c < end) {
+        c += 1;
+    }
+    return c;
+}
+
+// Cuts the lines from start to end into at most n_threads pieces of
+// whole lines, returning how many there are
+static int split_chunk(char *start, char *end, char delimiter, int n_threads,
+    struct parse_job *jobs) {
+
+    size_t length = end - start;
+    int n_jobs = length / MIN_PIECE_SIZE + 1;
+    if (n_jobs > n_threads) {
+        n_jobs = n_threads;
+    }
+    size_t piece_size = length / n_jobs;
+    char *piece_start = start;
+    int i = 0;
+    while (i < n_jobs) {
+        char *piece_end = end;
+        if (i < n_jobs - 1) {
+            piece_end = piece_start + piece_size;
+            if (piece_end > end) {
+                piece_end = end;
+            }
+            while (piece_end < end && piece_end[-1] != '\n') {
+                piece_end += 1;
+            }
+        }
+        jobs[i].start = piece_start;
+        jobs[i].end = piece_end;
+        jobs[i].delimiter = delimiter;
+        jobs[i].records = NULL;
+        jobs[i].n_records = 0;
+        jobs[i].capacity = 0;
+        jobs[i].n_lines = 0;
+        jobs[i].error_line = 0;
+        jobs[i].error = NULL;
+        piece_start = piece_end;
+        i += 1;
+    }
+    return n_jobs;
+}
+
+// Parses every line of one of the pieces into records, stopping at the
+// first invalid line (run as a task for each piece)
+static void parse_piece(void *jobs, int piece) {
+    struct parse_job *job = (struct parse_job *) jobs + piece;
+    char *line = job->start;
+    while (line < job->end) {
+        char *line_end = line;
+        while (line_end < job->end && *line_end != '\n') {
+            line_end += 1;
+        }
+        char *next = line_end;
+        if (next < job->end) {
+            next += 1;
+        }
+        job->n_lines += 1;
+        *line_end = '\0';
+        if (line_end > line && line_end[-1] == '\r') {
+            line_end[-1] = '\0';
+        }
+
+        if (!blank_line(line)) {
+            if (job->n_records == job->capacity) {
+                job->capacity = job->capacity == 0 ? 1024 : job->capacity * 2;
+                job->records = realloc(job->records,
+                    job->capacity * sizeof(struct import_record));
+                assert(job->records != NULL);
+            }
+            struct import_record *record = &job->records[job->n_records];
+            const char *error = parse_line(line, job->delimiter, record);
+            if (error != NULL) {
+                job->error = error;
+                job->error_line = job->n_lines;
+                return;
+            }
+            record->line = job->n_lines;
+            job->n_records += 1;
+        }
+        line = next;
+    }
+}
+
+// Splits a line into its fields and checks them, returning an error
+// message if the line does not describe a valid Pokemon
+static const char *parse_line(char *line, char delimiter,
+    struct import_record *record) {
+
+    char *fields[N_FIELDS];
+    int n_fields = 0;
+    char *field = line;
+    while (field != NULL) {
+        if (n_fields == N_FIELDS) {
+            return "too many fields";
+        }
+        char *after = strchr(field, delimiter);
+        if (after != NULL) {
+            *after = '\0';
+            after += 1;
+        }
+        fields[n_fields] = trim_field(field);
+        n_fields += 1;
+        field = after;
+    }
+    if (n_fields < N_FIELDS - 1) {
+        return "too few fields";
+    }
+
+    if (!parse_int(fields[0], &record->id) || record->id < 0) {
+        return "invalid pokemon_id";
+    }
+    record->name = fields[1];
+    if (record->name[0] == '\0' || !pokemon_valid_name(record->name)) {
+        return "invalid name";
+    }
+    if (!parse_double(fields[2], &record->height)) {
+        return "invalid height";
+    }
+    if (!parse_double(fields[3], &record->weight)) {
+        return "invalid weight";
+    }
+    record->type1 = pokemon_type_from_string(fields[4]);
+    if (record->type1 == INVALID_TYPE || record->type1 == NONE_TYPE) {
+        return "invalid type1";
+    }
+    record->type2 = NONE_TYPE;
+    if (fields[5][0] != '\0') {
+        record->type2 = pokemon_type_from_string(fields[5]);
+    }
+    if (record->type2 == INVALID_TYPE || record->type2 == record->type1) {
+        return "invalid type2";
+    }
+    record->evolution_id = NO_EVOLUTION;
+    if (n_fields == N_FIELDS && fields[6][0] != '\0') {
+        if (!parse_int(fields[6], &record->evolution_id) ||
+            record->evolution_id < 0 || record->evolution_id == record->id) {
+            return "invalid evolution_id";
+        }
+    }
+    return NULL;
+}
+
+// Returns 1 if the line is empty or only spaces, 0 otherwise
+static int blank_line(char *line) {
+    while (*line == ' ') {
+        line += 1;
+    }
+    return *line == '\0';
+}
+
+// Removes spaces and then double quotes from around a field, in place
+static char *trim_field(char *field) {
+    while (*field == ' ') {
+        field += 1;
+    }
+    char *end = field + strlen(field);
+    while (end > field && end[-1] == ' ') {
+        end -= 1;
+    }
+    if (end - field >= 2 && field[0] == '"' && end[-1] == '"') {
+        field += 1;
+        end -= 1;
+    }
+    *end = '\0';
+    return field;
+}
+
+// Reads a whole field as an int, returning 0 if it is not one
+static int parse_int(char *field, int *value) {
+    char *end = NULL;
+    long number = strtol(field, &end, 10);
+    if (end == field || *end != '\0' || number < -2147483647L ||
+        number > 2147483647L) {
+        return 0;
+    }
+    *value = number;
+    return 1;
+}
+
+// Reads a whole field as a double, returning 0 if it is not one.
+//
+// Plain decimals of up to MAX_EXACT_DIGITS digits (like every height
+// and weight) are read directly: the digits and the power of ten are
+// both exact doubles, so dividing them rounds the same way strtod
+// does. Anything else is left to strtod.
+static int parse_double(char *field, double *value) {
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+        1e13, 1e14, 1e15
+    };
+    char *c = field;
+    long long digits = 0;
+    int n_digits = 0;
+    int n_decimals = -1; // Digits after the point, -1 if there is none
+    while ((*c >= '0' && *c <= '9') || (*c == '.' && n_decimals < 0)) {
+        if (*c == '.') {
+            n_decimals = 0;
+        } else {
+            digits = digits * 10 + (*c - '0');
+            n_digits += 1;
+            if (n_decimals >= 0) {
+                n_decimals += 1;
+            }
+        }
+        c += 1;
+    }
+    if (*c == '\0' && n_digits > 0 && n_digits <= MAX_EXACT_DIGITS) {
+        *value = digits;
+        if (n_decimals > 0) {
+            *value /= powers_of_ten[n_decimals];
+        }
+        return 1;
+    }
+
+    char *end = NULL;
+    *value = strtod(field, &end);
+    return end != field && *end == '\0';
+}
+
+// Makes a Pokemon in the Pokedex's arena for each record of a parsed
+// piece, and keeps it with its line and evolution
+static void add_records(struct import_state *state, struct parse_job *job,
+    int first_line) {
+
+    if (state->n_pokemon + job->n_records > state->capacity) {
+        int capacity = state->capacity == 0 ? 1024 : state->capacity;
+        while (state->n_pokemon + job->n_records > capacity) {
+            capacity *= 2;
+        }
+        state->pokemon = realloc(state->pokemon, capacity * sizeof(Pokemon));
+        state->lines = realloc(state->lines, capacity * sizeof(int));
+        state->evolution_ids = realloc(state->evolution_ids, capacity * sizeof(int));
+        assert(state->pokemon != NULL && state->lines != NULL);
+        assert(state->evolution_ids != NULL);
+        state->capacity = capacity;
+    }
+    int i = 0;
+    while (i < job->n_records) {
+        struct import_record *record = &job->records[i];
+        int n = state->n_pokemon;
+        state->pokemon[n] = new_pokedex_pokemon(state->pokedex, record->id,
+            record->name, record->height, record->weight, record->type1,
+            record->type2);
+        state->lines[n] = first_line + record->line;
+        state->evolution_ids[n] = record->evolution_id;
+        state->n_pokemon += 1;
+        i += 1;
+    }
+}
+
+// Sorts every pokemon_id once to find repeated ones, evolutions to
+// Pokemon that are not in the file and evolutions that form a cycle,
+// returning an error message (and setting the line it is on) or NULL if
+// there are none
+static const char *check_ids(struct import_state *state, int *error_line) {
+    int n = state->n_pokemon;
+    struct id_and_line *ids = malloc((n + 1) * sizeof(struct id_and_line));
+    assert(ids != NULL);
+    int i = 0;
+    while (i < n) {
+        ids[i].id = pokemon_id(state->pokemon[i]);
+        ids[i].line = state->lines[i];
+        ids[i].index = i;
+        i += 1;
+    }
+    sort_ids(ids, n);
+
+    const char *error = NULL;
+    *error_line = 0;
+    i = 1;
+    while (i < n) {
+        // Of equal ids the later line comes second, and the earliest
+        // such line in the file is reported
+        if (ids[i].id == ids[i - 1].id &&
+            (error == NULL || ids[i].line < *error_line)) {
+            error = "repeated pokemon_id";
+            *error_line = ids[i].line;
+        }
+        i += 1;
+    }
+    // The Pokemon each one evolves into, by where it is in the file
+    int *next = malloc((n + 1) * sizeof(int));
+    assert(next != NULL);
+    i = 0;
+    while (error == NULL && i < n) {
+        int evolution_id = state->evolution_ids[i];
+        next[i] = -1;
+        if (evolution_id != NO_EVOLUTION) {
+            next[i] = find_id(ids, n, evolution_id);
+            if (next[i] == -1) {
+                error = "evolution_id is not in the file";
+                *error_line = state->lines[i];
+            }
+        }
+        i += 1;
+    }
+    if (error == NULL) {
+        int closing = find_cycle(next, n);
+        if (closing != -1) {
+            error = "evolutions form a cycle";
+            *error_line = state->lines[closing];
+        }
+    }
+    free(next);
+    free(ids);
+    return error;
+}
+
+// Sorts the ids in increasing order with a radix sort, a byte at a
+// time. Each pass is stable, so equal ids stay in file order.
+static void sort_ids(struct id_and_line *ids, int n_ids) {
+    if (n_ids == 0) {
+        return;
+    }
+    struct id_and_line *scratch = malloc((n_ids + 1) * sizeof(struct id_and_line));
+    assert(scratch != NULL);
+    struct id_and_line *from = ids;
+    struct id_and_line *to = scratch;
+    int shift = 0;
+    while (shift < 32) {
+        int counts[RADIX_SIZE] = {0};
+        int i = 0;
+        while (i < n_ids) {
+            counts[((unsigned int) from[i].id >> shift) & (RADIX_SIZE - 1)] += 1;
+            i += 1;
+        }
+        // Skips the pass if every id has the same byte here
+        if (counts[((unsigned int) from[0].id >> shift) & (RADIX_SIZE - 1)]
+            != n_ids) {
+            int total = 0;
+            i = 0;
+            while (i < RADIX_SIZE) {
+                int count = counts[i];
+                counts[i] = total;
+                total += count;
+                i += 1;
+            }
+            i = 0;
+            while (i < n_ids) {
+                int digit = ((unsigned int) from[i].id >> shift) & (RADIX_SIZE - 1);
+                to[counts[digit]] = from[i];
+                counts[digit] += 1;
+                i += 1;
+            }
+            struct id_and_line *swap = from;
+            from = to;
+            to = swap;
+        }
+        shift += RADIX_BITS;
+    }
+    if (from != ids) {
+        memcpy(ids, from, n_ids * sizeof(struct id_and_line));
+    }
+    free(scratch);
+}
+
+// Returns where in the file the Pokemon with the id in the sorted ids
+// is, or -1 if it is not there
+static int find_id(struct id_and_line *ids, int n_ids, int id) {
+    int low = 0;
+    int high = n_ids;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (ids[middle].id < id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low < n_ids && ids[low].id == id) {
+        return ids[low].index;
+    }
+    return -1;
+}
+
+// Follows the evolutions from every Pokemon in turn, returning the
+// Pokemon whose evolution closes the first cycle found, or -1 if the
+// evolutions form no cycle. Each Pokemon is walked through only once.
+static int find_cycle(int *next, int n) {
+    // 0 if not reached yet, 1 if on the current walk, 2 if its walk ended
+    char *visited = calloc(n + 1, 1);
+    assert(visited != NULL);
+    int closing = -1;
+    int i = 0;
+    while (closing == -1 && i < n) {
+        int last = -1;
+        int j = i;
+        while (j != -1 && visited[j] == 0) {
+            visited[j] = 1;
+            last = j;
+            j = next[j];
+        }
+        if (j != -1 && visited[j] == 1) {
+            closing = last;
+        }
+        j = i;
+        while (j != -1 && visited[j] == 1) {
+            visited[j] = 2;
+            j = next[j];
+        }
+        i += 1;
+    }
+    free(visited);
+    return closing;
+}
+
+// Frees the records of every piece
+static void free_jobs(struct parse_job *jobs, int n_jobs) {
+    int i = 0;
+    while (i < n_jobs) {
+        free(jobs[i].records);
+        i += 1;
+    }
+}
+
+// Frees the import's arrays, and its Pokedex if it has not been
+// returned (which frees every Pokemon made so far with it)
+static void free_state(struct import_state *state) {
+    if (state->pokedex != NULL) {
+        destroy_pokedex(state->pokedex);
+    }
+    free(state->pokemon);
+    free(state->lines);
+    free(state->evolution_ids);
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+// Bulk import of Pokemon from CSV or TSV files
+
+#include "pokedex.h"
+
+#ifndef _CSV_IMPORT_H_
+#define _CSV_IMPORT_H_
+
+// Create a new Pokedex holding every Pokemon in the CSV or TSV file at
+// `path`, in the order they appear in the file.
+//
+// Each line of the file describes one Pokemon with the fields
+//
+//   pokemon_id, name, height, weight, type1, type2, evolution_id
+//
+// separated by commas, or by tabs if the first line has a tab in it.
+// type2 may be empty or "None" for a Pokemon with one type, and
+// evolution_id (which may be left off) is the pokemon_id of the Pokemon
+// it evolves into, or empty if it does not evolve. Fields may be
+// wrapped in double quotes. If the first field of the first line is not
+// a number, that line is a header and is skipped. Blank lines are
+// skipped.
+//
+// The file is read in chunks, and the lines of each chunk are parsed in
+// up to `n_threads` pieces at once (or one per processor if `n_threads`
+// is 0 or less), run on the process-wide task pool (see
+// default_task_pool) rather than on threads of their own. The Pokemon
+// are then added with add_pokemon_bulk, once every pokemon_id has been
+// checked for duplicates in one pass, and the evolutions are added
+// last. The Pokedex is an arena Pokedex (see
+// new_arena_pokedex).
+//
+// If the file cannot be read, or a line is invalid (e.g. an invalid
+// name according to pokemon_valid_name, an unknown type, a repeated
+// pokemon_id, an evolution to a Pokemon not in the file, or evolutions
+// that form a cycle), an error message giving the line is printed and
+// NULL is returned.
+Pokedex import_pokedex(char *path, int n_threads);
+
+#endif // _CSV_IMPORT_H_
\ No newline at end of file
@@ -0,0 +1,245 @@
+// Ordered index from pokemon_id to a value, kept as a B+ tree
+//
+// Each node holds up to NODE_KEYS ids in ascending order. Leaves hold
+// the values and are chained together in order of id, and every other
+// node holds, for each child, the smallest id that can be found under
+// it. Lookups go from the root to a leaf touching one node per level,
+// so a million ids are only four levels deep.
+//
+// A node that fills up is split in two. Nodes are never merged when ids
+// are removed, and empty leaves are skipped over by id_order_visit: an
+// id added later in an empty leaf's range goes back into it.
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "id_order.h"
+
+#define NODE_KEYS 32
+
+struct id_order_node {
+    int is_leaf;
+    int count;
+    int keys[NODE_KEYS];
+    union {
+        void *values[NODE_KEYS];                   // In a leaf
+        struct id_order_node *children[NODE_KEYS]; // Otherwise
+    } items;
+    struct id_order_node *next; // The next leaf, NULL if not a leaf
+};
+
+struct id_order {
+    struct id_order_node *root;
+    int count;
+};
+
+static struct id_order_node *new_node(int is_leaf);
+static struct id_order_node *insert_into(struct id_order_node *node, int id,
+    void *value);
+static struct id_order_node *split_node(struct id_order_node *node);
+static int child_for(struct id_order_node *node, int id);
+static int first_not_below(struct id_order_node *node, int id);
+static void free_node(struct id_order_node *node);
+
+IdOrder new_id_order(void) {
+    IdOrder order = malloc(sizeof(struct id_order));
+    assert(order != NULL);
+    order->root = new_node(1);
+    order->count = 0;
+    return order;
+}
+
+// Inserts into the root, growing the tree by a level if the root splits
+void id_order_insert(IdOrder order, int id, void *value) {
+    struct id_order_node *split = insert_into(order->root, id, value);
+    if (split != NULL) {
+        struct id_order_node *root = new_node(0);
+        root->keys[0] = order->root->keys[0];
+        root->items.children[0] = order->root;
+        root->keys[1] = split->keys[0];
+        root->items.children[1] = split;
+        root->count = 2;
+        order->root = root;
+    }
+    order->count += 1;
+}
+
+// Takes the id out of its leaf, leaving the nodes above unchanged
+void id_order_remove(IdOrder order, int id) {
+    struct id_order_node *node = order->root;
+    while (!node->is_leaf) {
+        node = node->items.children[child_for(node, id)];
+    }
+    int i = first_not_below(node, id);
+    if (i == node->count || node->keys[i] != id) {
+        return;
+    }
+    while (i + 1 < node->count) {
+        node->keys[i] = node->keys[i + 1];
+        node->items.values[i] = node->items.values[i + 1];
+        i += 1;
+    }
+    node->count -= 1;
+    order->count -= 1;
+}
+
+// Finds the leaf that min_id belongs in, then follows the chain of
+// leaves until an id is larger than max_id
+void id_order_visit(IdOrder order, int min_id, int max_id,
+    void (*visit)(void *value, void *context), void *context) {
+
+    struct id_order_node *node = order->root;
+    while (!node->is_leaf) {
+        node = node->items.children[child_for(node, min_id)];
+    }
+    int i = first_not_below(node, min_id);
+    while (node != NULL) {
+        while (i < node->count) {
+            if (node->keys[i] > max_id) {
+                return;
+            }
+            visit(node->items.values[i], context);
+            i += 1;
+        }
+        node = node->next;
+        i = 0;
+    }
+}
+
+// Returns the number of ids in the index
+int id_order_count(IdOrder order) {
+    return order->count;
+}
+
+// Frees every node, then the index
+void destroy_id_order(IdOrder order) {
+    free_node(order->root);
+    free(order);
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//                         [EXTRA FUNCTIONS]                          //
+////////////////////////////////////////////////////////////////////////
+
+// Allocates an empty node
+static struct id_order_node *new_node(int is_leaf) {
+    struct id_order_node *node = malloc(sizeof(struct id_order_node));
+    assert(node != NULL);
+    node->is_leaf = is_leaf;
+    node->count = 0;
+    node->next = NULL;
+    return node;
+}
+
+// Inserts the id under the node, returning the new node holding the
+// upper half of the node if it had to be split, NULL otherwise
+static struct id_order_node *insert_into(struct id_order_node *node, int id,
+    void *value) {
+
+    int i = 0;
+    void *item = value;
+    if (node->is_leaf) {
+        i = first_not_below(node, id);
+        assert(i == node->count || node->keys[i] != id);
+    } else {
+        int child = child_for(node, id);
+        // The child's smallest id may now be this one
+        if (id < node->keys[child]) {
+            node->keys[child] = id;
+        }
+        struct id_order_node *split = insert_into(node->items.children[child],
+            id, value);
+        if (split == NULL) {
+            return NULL;
+        }
+        // The child was split, so the new half goes in after it
+        i = child + 1;
+        id = split->keys[0];
+        item = split;
+    }
+
+    struct id_order_node *split = NULL;
+    struct id_order_node *target = node;
+    if (node->count == NODE_KEYS) {
+        split = split_node(node);
+        if (i > node->count) {
+            target = split;
+            i -= node->count;
+        }
+    }
+    int j = target->count;
+    while (j > i) {
+        target->keys[j] = target->keys[j - 1];
+        target->items.values[j] = target->items.values[j - 1];
+        j -= 1;
+    }
+    target->keys[i] = id;
+    target->items.values[i] = item;
+    target->count += 1;
+    return split;
+}
+
+// Moves the upper half of a full node into a new node after it
+static struct id_order_node *split_node(struct id_order_node *node) {
+    struct id_order_node *upper = new_node(node->is_leaf);
+    int half = NODE_KEYS / 2;
+    int i = half;
+    while (i < NODE_KEYS) {
+        upper->keys[i - half] = node->keys[i];
+        upper->items.values[i - half] = node->items.values[i];
+        i += 1;
+    }
+    upper->count = NODE_KEYS - half;
+    node->count = half;
+    if (node->is_leaf) {
+        upper->next = node->next;
+        node->next = upper;
+    }
+    return upper;
+}
+
+// Returns the index of the child of a non-leaf node whose ids could
+// include `id`: the last child whose smallest id is not above it, or the
+// first child if every child's ids are above it
+static int child_for(struct id_order_node *node, int id) {
+    int low = 0;
+    int high = node->count - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (node->keys[middle] <= id) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+// Returns the index of the first id in a leaf that is not below `id`,
+// or the leaf's count if there is none
+static int first_not_below(struct id_order_node *node, int id) {
+    int low = 0;
+    int high = node->count;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (node->keys[middle] < id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Frees the node and every node under it
+static void free_node(struct id_order_node *node) {
+    if (!node->is_leaf) {
+        int i = 0;
+        while (i < node->count) {
+            free_node(node->items.children[i]);
+            i += 1;
+        }
+    }
+    free(node);
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+// Ordered index from pokemon_id to a value, kept as a B+ tree
+
+#ifndef _ID_ORDER_H_
+#define _ID_ORDER_H_
+
+typedef struct id_order *IdOrder;
+
+// Create a new, empty ordered index.
+// It is the caller's responsibility to call 'destroy_id_order' to free
+// its memory.
+IdOrder new_id_order(void);
+
+// Add `value` to the index under `id`, which must not already be in the
+// index. Takes O(log n) time.
+void id_order_insert(IdOrder order, int id, void *value);
+
+// Remove `id` from the index, doing nothing if it is not there. Takes
+// O(log n) time.
+void id_order_remove(IdOrder order, int id);
+
+// Call `visit(value, context)` for the value of every id from `min_id`
+// to `max_id` (inclusive), in ascending order of id. Takes O(log n + k)
+// time to visit k values.
+//
+// The index must not be changed by `visit`.
+void id_order_visit(IdOrder order, int min_id, int max_id,
+    void (*visit)(void *value, void *context), void *context);
+
+// Return the number of ids in the index.
+int id_order_count(IdOrder order);
+
+// Free all of the memory used by the index (but not the values).
+void destroy_id_order(IdOrder order);
+
+#endif // _ID_ORDER_H_
\ No newline at end of file
@@ -0,0 +1,56 @@
+// Command line tool to import Pokemon from a CSV or TSV file
+//
+// Usage: ./import_pokedex <file> [snapshot] [threads]
+//
+// Imports every Pokemon in the file with import_pokedex and prints how
+// many there are. If a snapshot path is given, the Pokedex is also
+// saved there with save_pokedex, to be loaded later with load_pokedex.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "pokedex.h"
+#include "csv_import.h"
+
+static double now_seconds(void);
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 4) {
+        fprintf(stderr, "Usage: %s <file> [snapshot] [threads]\n", argv[0]);
+        return 1;
+    }
+    int n_threads = 0;
+    if (argc == 4) {
+        n_threads = atoi(argv[3]);
+    }
+
+    double start = now_seconds();
+    Pokedex pokedex = import_pokedex(argv[1], n_threads);
+    if (pokedex == NULL) {
+        return 1;
+    }
+    double elapsed = now_seconds() - start;
+    printf("Imported %d Pokemon from %s in %.3f seconds\n",
+        count_total_pokemon(pokedex), argv[1], elapsed);
+
+    if (argc >= 3) {
+        if (!save_pokedex(pokedex, argv[2])) {
+            fprintf(stderr, "%s: cannot save snapshot\n", argv[2]);
+            destroy_pokedex(pokedex);
+            return 1;
+        }
+        printf("Saved the Pokedex to %s\n", argv[2]);
+    }
+    destroy_pokedex(pokedex);
+    return 0;
+}
+
+// Returns the current time in seconds, from a monotonic clock.
+static double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
\ No newline at end of file
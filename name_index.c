@@ -0,0 +1,213 @@
+// Index of the short substrings (grams) of Pokemon names
+//
+// Once lowercased, each letter, space or dash of a name is one of the
+// symbols, and every other character (a digit, say) shares the last
+// symbol. Every gram of up to three symbols has its own posting list of
+// the slots whose names contain it. A query is answered by intersecting
+// the posting lists of its grams, which may give a few extra candidates
+// when other characters share a symbol, but never misses a name.
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "name_index.h"
+
+#define NAME_SYMBOLS 29
+#define OTHER_SYMBOL 28
+#define NOT_A_SYMBOL (-1)
+
+// Slots (in increasing order) of the names containing one gram
+struct posting_list {
+    int *slots;
+    int length;
+    int capacity;
+};
+
+struct name_index {
+    struct posting_list unigrams[NAME_SYMBOLS];
+    struct posting_list bigrams[NAME_SYMBOLS * NAME_SYMBOLS];
+    struct posting_list trigrams[NAME_SYMBOLS * NAME_SYMBOLS * NAME_SYMBOLS];
+};
+
+static int symbol(char character);
+static void posting_add(struct posting_list *list, int slot);
+static struct posting_list *query_list(NameIndex index, int *symbols, int length,
+    int start);
+static int intersect(int *result, int result_length, struct posting_list *list);
+static void free_lists(struct posting_list *lists, int n_lists);
+
+NameIndex new_name_index(void) {
+    NameIndex index = calloc(1, sizeof(struct name_index));
+    assert(index != NULL);
+    return index;
+}
+
+// Records every gram of the name against the slot
+void name_index_add(NameIndex index, int slot, char *name) {
+    int previous = NOT_A_SYMBOL;  // Symbol one character back
+    int previous2 = NOT_A_SYMBOL; // Symbol two characters back
+    int i = 0;
+    while (name[i] != '\0') {
+        int current = symbol(name[i]);
+        posting_add(&index->unigrams[current], slot);
+        if (previous != NOT_A_SYMBOL) {
+            posting_add(&index->bigrams[previous * NAME_SYMBOLS + current], slot);
+        }
+        if (previous2 != NOT_A_SYMBOL) {
+            int gram = (previous2 * NAME_SYMBOLS + previous) * NAME_SYMBOLS + current;
+            posting_add(&index->trigrams[gram], slot);
+        }
+        previous2 = previous;
+        previous = current;
+        i += 1;
+    }
+}
+
+// Intersects the posting lists of the text's grams
+int name_index_candidates(NameIndex index, char *text, int **candidates) {
+    *candidates = NULL;
+
+    // Converts the text to symbols
+    int length = 0;
+    while (text[length] != '\0') {
+        length += 1;
+    }
+    if (length == 0) {
+        return 0;
+    }
+    int *symbols = malloc(length * sizeof(int));
+    assert(symbols != NULL);
+    int i = 0;
+    while (i < length) {
+        symbols[i] = symbol(text[i]);
+        i += 1;
+    }
+
+    // Starts from the shortest posting list of the text's grams, so the
+    // result never has to grow
+    struct posting_list *shortest = query_list(index, symbols, length, 0);
+    int start = 1;
+    while (start + 3 <= length) {
+        struct posting_list *list = query_list(index, symbols, length, start);
+        if (list->length < shortest->length) {
+            shortest = list;
+        }
+        start += 1;
+    }
+    if (shortest->length == 0) {
+        free(symbols);
+        return 0;
+    }
+
+    int *result = malloc(shortest->length * sizeof(int));
+    assert(result != NULL);
+    int result_length = shortest->length;
+    i = 0;
+    while (i < result_length) {
+        result[i] = shortest->slots[i];
+        i += 1;
+    }
+    start = 0;
+    while (start == 0 || start + 3 <= length) {
+        struct posting_list *list = query_list(index, symbols, length, start);
+        if (list != shortest) {
+            result_length = intersect(result, result_length, list);
+        }
+        start += 1;
+    }
+    free(symbols);
+
+    if (result_length == 0) {
+        free(result);
+        return 0;
+    }
+    *candidates = result;
+    return result_length;
+}
+
+// Frees every posting list, and the index
+void destroy_name_index(NameIndex index) {
+    free_lists(index->unigrams, NAME_SYMBOLS);
+    free_lists(index->bigrams, NAME_SYMBOLS * NAME_SYMBOLS);
+    free_lists(index->trigrams, NAME_SYMBOLS * NAME_SYMBOLS * NAME_SYMBOLS);
+    free(index);
+}
+
+// Returns the symbol (0 to NAME_SYMBOLS - 1) of a name character,
+// treating upper and lower case letters the same, and giving every
+// character other than a letter, space or dash OTHER_SYMBOL
+static int symbol(char character) {
+    if (character >= 'a' && character <= 'z') {
+        return character - 'a';
+    } else if (character >= 'A' && character <= 'Z') {
+        return character - 'A';
+    } else if (character == ' ') {
+        return 26;
+    } else if (character == '-') {
+        return 27;
+    }
+    return OTHER_SYMBOL;
+}
+
+// Adds the slot to the end of the posting list, unless it is already
+// there (a gram that appears twice in one name)
+static void posting_add(struct posting_list *list, int slot) {
+    if (list->length > 0 && list->slots[list->length - 1] == slot) {
+        return;
+    }
+    if (list->length == list->capacity) {
+        list->capacity = list->capacity * 2;
+        if (list->capacity == 0) {
+            list->capacity = 4;
+        }
+        list->slots = realloc(list->slots, list->capacity * sizeof(int));
+        assert(list->slots != NULL);
+    }
+    list->slots[list->length] = slot;
+    list->length += 1;
+}
+
+// Returns the posting list of the gram starting at symbols[start]: the
+// trigram there, or the whole text if it is shorter than three symbols
+static struct posting_list *query_list(NameIndex index, int *symbols, int length,
+    int start) {
+
+    if (length == 1) {
+        return &index->unigrams[symbols[0]];
+    } else if (length == 2) {
+        return &index->bigrams[symbols[0] * NAME_SYMBOLS + symbols[1]];
+    }
+    int gram = (symbols[start] * NAME_SYMBOLS + symbols[start + 1]) * NAME_SYMBOLS
+        + symbols[start + 2];
+    return &index->trigrams[gram];
+}
+
+// Keeps only the slots of result that are also in the posting list,
+// returning the new length of result. Both are in increasing order.
+static int intersect(int *result, int result_length, struct posting_list *list) {
+    int kept = 0;
+    int i = 0;
+    int j = 0;
+    while (i < result_length && j < list->length) {
+        if (result[i] < list->slots[j]) {
+            i += 1;
+        } else if (result[i] > list->slots[j]) {
+            j += 1;
+        } else {
+            result[kept] = result[i];
+            kept += 1;
+            i += 1;
+            j += 1;
+        }
+    }
+    return kept;
+}
+
+// Frees the slots of each posting list in the array
+static void free_lists(struct posting_list *lists, int n_lists) {
+    int i = 0;
+    while (i < n_lists) {
+        free(lists[i].slots);
+        i += 1;
+    }
+}
\ No newline at end of file
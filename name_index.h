@@ -0,0 +1,35 @@
+// Index of the short substrings (grams) of Pokemon names
+
+#ifndef _NAME_INDEX_H_
+#define _NAME_INDEX_H_
+
+typedef struct name_index *NameIndex;
+
+// Create a new, empty name index.
+// It is the caller's responsibility to call 'destroy_name_index' to
+// free its memory.
+NameIndex new_name_index(void);
+
+// Add the name of the Pokemon in slot `slot` to the index.
+//
+// Every lowercase trigram, bigram and unigram of the name is recorded
+// against the slot. Slots must be added in increasing order.
+void name_index_add(NameIndex index, int slot, char *name);
+
+// Find the slots whose names might contain `text` (ignoring case).
+//
+// Returns the number of candidate slots, and sets `*candidates` to a
+// malloced array of them in increasing order, which the caller must
+// free. Every slot whose name does contain the text is a candidate,
+// but a candidate's name must still be checked when the text is longer
+// than three characters or has characters other than letters, spaces
+// and dashes.
+//
+// Returns 0 (and sets `*candidates` to NULL) if no name can contain the
+// text, e.g. if it is empty.
+int name_index_candidates(NameIndex index, char *text, int **candidates);
+
+// Free all of the memory used by the index.
+void destroy_name_index(NameIndex index);
+
+#endif // _NAME_INDEX_H_
\ No newline at end of file
@@ -0,0 +1,205 @@
+// Case-insensitive substring search over Pokemon names
+//
+// Setting bit 0x20 lowercases a letter while leaving a space or dash
+// unchanged, so a name is folded one vector at a time with a single OR.
+// Each vector of start positions is filtered by comparing both the
+// first and the last character of the text, folded the same way, at
+// once. The OR can also make two different characters that are not
+// letters equal (e.g. '@' and '`'), so the positions where both match
+// have the whole text checked, lowercasing only letters. Vectors are
+// only loaded while they fit in the name, and the start positions left
+// over are checked one at a time.
+//
+// The widest version the CPU supports (AVX2, SSE2 or plain C) is chosen
+// once, the first time name_match is called on any thread.
+
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NAME_MATCH_X86
+#endif
+
+#include "name_match.h"
+
+#define FOLD_BIT 0x20
+
+typedef int (*match_function)(char *name, int name_length, char *folded,
+    int folded_length);
+
+static void choose_match(void);
+static int match_scalar(char *name, int name_length, char *folded,
+    int folded_length);
+static int match_from(char *name, int name_length, char *folded,
+    int folded_length, int start);
+static int text_matches(char *name, char *folded, int folded_length);
+static char fold_character(char character);
+#ifdef NAME_MATCH_X86
+static int match_sse2(char *name, int name_length, char *folded,
+    int folded_length);
+static int match_avx2(char *name, int name_length, char *folded,
+    int folded_length);
+#endif
+
+static match_function match = NULL;
+static pthread_once_t match_chosen = PTHREAD_ONCE_INIT;
+
+// Lowercases the letters of a copy of the text
+int name_match_fold(char *text, char **folded) {
+    int length = 0;
+    while (text[length] != '\0') {
+        length += 1;
+    }
+    if (length == 0) {
+        *folded = NULL;
+        return 0;
+    }
+
+    char *copy = malloc(length + 1);
+    assert(copy != NULL);
+    int i = 0;
+    while (i < length) {
+        copy[i] = fold_character(text[i]);
+        i += 1;
+    }
+    copy[length] = '\0';
+    *folded = copy;
+    return length;
+}
+
+// Checks whether the folded text occurs in the name
+int name_match(char *name, int name_length, char *folded, int folded_length) {
+    if (folded_length > name_length) {
+        return 0;
+    }
+    pthread_once(&match_chosen, choose_match);
+    return match(name, name_length, folded, folded_length);
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//                         [EXTRA FUNCTIONS]                          //
+////////////////////////////////////////////////////////////////////////
+
+// Sets match to the widest matcher the CPU running us supports
+static void choose_match(void) {
+    match = match_scalar;
+#ifdef NAME_MATCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        match = match_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        match = match_sse2;
+    }
+#endif
+}
+
+// Checks every start position one at a time
+static int match_scalar(char *name, int name_length, char *folded,
+    int folded_length) {
+    return match_from(name, name_length, folded, folded_length, 0);
+}
+
+// Checks the start positions from `start` on one at a time
+static int match_from(char *name, int name_length, char *folded,
+    int folded_length, int start) {
+    char first = folded[0] | FOLD_BIT;
+    char last = folded[folded_length - 1] | FOLD_BIT;
+    int last_start = name_length - folded_length;
+    while (start <= last_start) {
+        if ((name[start] | FOLD_BIT) == first &&
+            (name[start + folded_length - 1] | FOLD_BIT) == last &&
+            text_matches(name + start, folded, folded_length)) {
+            return 1;
+        }
+        start += 1;
+    }
+    return 0;
+}
+
+// Checks every character of the folded text against the name starting
+// at `name`
+static int text_matches(char *name, char *folded, int folded_length) {
+    int i = 0;
+    while (i < folded_length) {
+        if (fold_character(name[i]) != folded[i]) {
+            return 0;
+        }
+        i += 1;
+    }
+    return 1;
+}
+
+// Lowercases the character if it is a letter
+static char fold_character(char character) {
+    if (character >= 'A' && character <= 'Z') {
+        return character | FOLD_BIT;
+    }
+    return character;
+}
+
+#ifdef NAME_MATCH_X86
+
+// Checks 16 start positions at a time
+__attribute__((target("sse2")))
+static int match_sse2(char *name, int name_length, char *folded,
+    int folded_length) {
+    __m128i fold = _mm_set1_epi8(FOLD_BIT);
+    __m128i first = _mm_set1_epi8(folded[0] | FOLD_BIT);
+    __m128i last = _mm_set1_epi8(folded[folded_length - 1] | FOLD_BIT);
+    // Both loads stay inside the name for every block of starts
+    int start = 0;
+    while (start + folded_length + 15 <= name_length) {
+        __m128i block_first = _mm_loadu_si128((__m128i *) (name + start));
+        __m128i block_last = _mm_loadu_si128(
+            (__m128i *) (name + start + folded_length - 1));
+        block_first = _mm_or_si128(block_first, fold);
+        block_last = _mm_or_si128(block_last, fold);
+        unsigned int candidates = _mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(block_first, first),
+            _mm_cmpeq_epi8(block_last, last)));
+        while (candidates != 0) {
+            int offset = __builtin_ctz(candidates);
+            if (text_matches(name + start + offset, folded, folded_length)) {
+                return 1;
+            }
+            candidates &= candidates - 1;
+        }
+        start += 16;
+    }
+    return match_from(name, name_length, folded, folded_length, start);
+}
+
+// Checks 32 start positions at a time
+__attribute__((target("avx2")))
+static int match_avx2(char *name, int name_length, char *folded,
+    int folded_length) {
+    __m256i fold = _mm256_set1_epi8(FOLD_BIT);
+    __m256i first = _mm256_set1_epi8(folded[0] | FOLD_BIT);
+    __m256i last = _mm256_set1_epi8(folded[folded_length - 1] | FOLD_BIT);
+    // Both loads stay inside the name for every block of starts
+    int start = 0;
+    while (start + folded_length + 31 <= name_length) {
+        __m256i block_first = _mm256_loadu_si256((__m256i *) (name + start));
+        __m256i block_last = _mm256_loadu_si256(
+            (__m256i *) (name + start + folded_length - 1));
+        block_first = _mm256_or_si256(block_first, fold);
+        block_last = _mm256_or_si256(block_last, fold);
+        unsigned int candidates = _mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(block_first, first),
+            _mm256_cmpeq_epi8(block_last, last)));
+        while (candidates != 0) {
+            int offset = __builtin_ctz(candidates);
+            if (text_matches(name + start + offset, folded, folded_length)) {
+                return 1;
+            }
+            candidates &= candidates - 1;
+        }
+        start += 32;
+    }
+    return match_from(name, name_length, folded, folded_length, start);
+}
+
+#endif
\ No newline at end of file
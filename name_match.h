@@ -0,0 +1,19 @@
+// Case-insensitive substring search over Pokemon names
+
+#ifndef _NAME_MATCH_H_
+#define _NAME_MATCH_H_
+
+// Fold `text` for searching with name_match.
+//
+// Returns the length of the folded text, and sets `*folded` to a
+// malloced copy of it with its letters lowercased, which the caller
+// must free.
+//
+// Returns 0 (and sets `*folded` to NULL) if the text is empty.
+int name_match_fold(char *text, char **folded);
+
+// Returns 1 if `folded` (from name_match_fold) occurs in the first
+// `name_length` characters of the name ignoring case, 0 otherwise.
+int name_match(char *name, int name_length, char *folded, int folded_length);
+
+#endif // _NAME_MATCH_H_
\ No newline at end of file
@@ -0,0 +1,120 @@
+// Pool of interned Pokemon names, shared by reference counting
+//
+// Names are copied into an arena, and an open-addressing (linear
+// probing) table of them finds an existing copy. The pool is shared by
+// every Pokemon whose name is in it, and by the Pokedex that made them,
+// so that clones can share names instead of copying them.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arena.h"
+#include "name_pool.h"
+
+#define INITIAL_POOL_CAPACITY 64
+
+// One name in the table, with its hash so that most names which do not
+// match can be skipped without comparing them
+struct pool_entry {
+    uint32_t hash;
+    char *name; // NULL if the entry is empty
+};
+
+struct name_pool {
+    int references;
+    Arena arena; // Holds the copies of the names
+    struct pool_entry *entries;
+    int capacity; // Always a power of two
+    int count;
+};
+
+static uint32_t hash_name(char *name, size_t *length);
+static void grow_pool(NamePool pool);
+
+NamePool new_name_pool(void) {
+    NamePool pool = malloc(sizeof(struct name_pool));
+    assert(pool != NULL);
+    pool->references = 1;
+    pool->arena = new_arena();
+    pool->capacity = INITIAL_POOL_CAPACITY;
+    pool->count = 0;
+    pool->entries = calloc(pool->capacity, sizeof(struct pool_entry));
+    assert(pool->entries != NULL);
+    return pool;
+}
+
+// Looks for the name in the table, adding a copy where the search ended
+// if it is not there
+char *name_pool_intern(NamePool pool, char *name) {
+    size_t length = 0;
+    uint32_t hash = hash_name(name, &length);
+    int mask = pool->capacity - 1;
+    int i = hash & mask;
+    while (pool->entries[i].name != NULL) {
+        if (pool->entries[i].hash == hash &&
+            memcmp(pool->entries[i].name, name, length + 1) == 0) {
+            return pool->entries[i].name;
+        }
+        i = (i + 1) & mask;
+    }
+
+    char *copy = arena_alloc(pool->arena, length + 1);
+    memcpy(copy, name, length + 1);
+    pool->entries[i].hash = hash;
+    pool->entries[i].name = copy;
+    pool->count += 1;
+    // Keeps the table at most half full
+    if (pool->count * 2 > pool->capacity) {
+        grow_pool(pool);
+    }
+    return copy;
+}
+
+void name_pool_retain(NamePool pool) {
+    __atomic_add_fetch(&pool->references, 1, __ATOMIC_RELAXED);
+}
+
+// Frees the pool when the last reference is removed
+void name_pool_release(NamePool pool) {
+    if (__atomic_sub_fetch(&pool->references, 1, __ATOMIC_ACQ_REL) == 0) {
+        destroy_arena(pool->arena);
+        free(pool->entries);
+        free(pool);
+    }
+}
+
+// Returns the FNV-1a hash of the name, and sets its length
+static uint32_t hash_name(char *name, size_t *length) {
+    uint32_t hash = 2166136261u;
+    size_t i = 0;
+    while (name[i] != '\0') {
+        hash = (hash ^ (unsigned char) name[i]) * 16777619u;
+        i += 1;
+    }
+    *length = i;
+    return hash;
+}
+
+// Doubles the table, moving every name to its place in the new one
+static void grow_pool(NamePool pool) {
+    struct pool_entry *old_entries = pool->entries;
+    int old_capacity = pool->capacity;
+    pool->capacity *= 2;
+    pool->entries = calloc(pool->capacity, sizeof(struct pool_entry));
+    assert(pool->entries != NULL);
+    int mask = pool->capacity - 1;
+    int i = 0;
+    while (i < old_capacity) {
+        if (old_entries[i].name != NULL) {
+            int j = old_entries[i].hash & mask;
+            while (pool->entries[j].name != NULL) {
+                j = (j + 1) & mask;
+            }
+            pool->entries[j] = old_entries[i];
+        }
+        i += 1;
+    }
+    free(old_entries);
+}
\ No newline at end of file
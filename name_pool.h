@@ -0,0 +1,31 @@
+// Pool of interned Pokemon names, shared by reference counting
+
+#ifndef _NAME_POOL_H_
+#define _NAME_POOL_H_
+
+typedef struct name_pool *NamePool;
+
+// Create a new, empty name pool holding one reference.
+// It is the caller's responsibility to call 'name_pool_release' once it
+// no longer needs the pool.
+NamePool new_name_pool(void);
+
+// Return the pool's copy of `name`, copying it into the pool if it is
+// not already there.
+//
+// Every call with an equal name returns the same pointer, which stays
+// valid for as long as the pool does. The returned string must not be
+// changed or freed by the caller.
+//
+// Interning is not safe to do from more than one thread at a time.
+char *name_pool_intern(NamePool pool, char *name);
+
+// Add a reference to the pool, so that it lives until a matching
+// 'name_pool_release'. This can be called from any thread.
+void name_pool_retain(NamePool pool);
+
+// Remove a reference to the pool, freeing it and every name in it once
+// no references are left. This can be called from any thread.
+void name_pool_release(NamePool pool);
+
+#endif // _NAME_POOL_H_
\ No newline at end of file
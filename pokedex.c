@@ -3,125 +3,471 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "pokedex.h"
+#include "name_index.h"
+#include "name_match.h"
+#include "id_order.h"
+#include "task_pool.h"
+
+#define BITS_PER_WORD 64
+
+#define SNAPSHOT_MAGIC "POKEDEX"
+#define SNAPSHOT_VERSION 1
+#define NO_SELECTED_ID (-1)
+#define LOAD_PREFETCH_DISTANCE 16
+
+// Bulk operations are only split into chunks for a TaskPool when every
+// chunk gets at least this many words of type bitsets, name candidates
+// or slots, so that sharing them out pays for itself. There are at most
+// CHUNKS_PER_THREAD chunks per thread, so that threads which finish
+// early have chunks left to steal.
+#define CHUNKS_PER_THREAD 4
+#define TYPE_FILTER_GRAIN 1024
+#define SEARCH_FILTER_GRAIN 16384
+#define EXPLORE_SCAN_GRAIN 65536
+#define TEARDOWN_GRAIN 16384
+
+// The Pokemon of a Pokedex laid out as parallel arrays, indexed by slot.
+//
+// Slots are handed out in the order Pokemon are added, so walking the
+// slots visits Pokemon in Pokedex order. Only the bitsets are kept
+// here; everything else about a Pokemon is read through its node.
+// A removed Pokemon leaves a hole (NULL node, not found, in no bitset)
+// which no scan can match, until the columns are compacted.
+struct pokedex_columns {
+    int length;   // Number of slots in use, including holes
+    int capacity; // Number of slots allocated, a multiple of BITS_PER_WORD
+    int holes;    // Number of slots belonging to removed Pokemon
+
+    struct pokenode **node;
+
+    // Bitsets with one bit per slot: the found Pokemon, the found
+    // Pokemon already added to the Pokedex's found_order, and for each
+    // pokemon_type the Pokemon of that type (the NONE_TYPE bitset holds
+    // the Pokemon with only one type)
+    uint64_t *found_bits;
+    uint64_t *ordered_bits;
+    uint64_t *type_bits[MAX_TYPE];
+};
+
+// A query result referring to pokenodes in another Pokedex
+struct pokedex_view {
+    struct pokenode **nodes; // The matching pokenodes, in view order
+    int length;
+    int capacity;
+    int selected; // Index in nodes of the selected Pokemon
+};
+
+// Adds the matching items from first to last - 1 of a query to the view
+typedef void (*query_filter)(Pokedex pokedex, void *query, int first,
+    int last, PokedexView view);
+
+// A query split into chunks by filter_in_parallel
+struct chunked_filter {
+    Pokedex pokedex;
+    query_filter filter;
+    void *query;
+    int n_items;
+    int n_chunks;
+    PokedexView *views; // Each chunk's matches, in Pokedex order
+};
+
+// explore_sampled's scan for Pokemon that can be found, split into
+// chunks of slots
+struct explore_scan {
+    Pokedex pokedex;
+    int factor;
+    int n_items;
+    int n_chunks;
+    int *eligible; // Each chunk's eligible slots, from its first slot on
+    int *counts;   // Number of eligible slots in each chunk
+};
+
+// destroy_pokedex's freeing of the Pokemon, split into chunks of slots
+struct teardown {
+    Pokedex pokedex;
+    int n_items;
+    int n_chunks;
+};
+
+// A Pokemon moved out of a Pokedex by merge_pokedexes
+struct taken_pokemon {
+    Pokemon pokemon;
+    int found;
+};
+
+// The bitsets combined by view_pokemon_matching
+struct type_query {
+    uint64_t *first_bits;
+    uint64_t *second_bits;
+    int need_both;
+};
+
+// The names checked by view_searched
+struct search_query {
+    int *candidates; // Slots whose names might hold the text, in order
+    char *folded;
+    int folded_length;
+};
+
+// A currently selected Pokemon of its own, kept apart from the
+// Pokedex's. Every cursor of a Pokedex is in a list so that removing a
+// Pokemon can move the cursors that were on it.
+struct pokedex_cursor {
+    Pokedex pokedex;
+    struct pokenode *node; // Selected pokenode, NULL if Pokedex is empty
+    struct pokedex_cursor *prev;
+    struct pokedex_cursor *next;
+};
 
 struct pokedex {
     struct pokenode *head;
+    struct pokenode *tail;
+    struct pokenode *selected; // Currently selected Pokemon, NULL if empty
+    struct pokedex_cursor *cursors; // Cursors made by new_pokedex_cursor
+
+    int total; // Number of Pokemon in the Pokedex
+    int found; // Number of those Pokemon that have been found, counted
+               // atomically by whichever thread sets each one's found bit
+
+    exploring_mode exploring_mode; // How go_exploring picks Pokemon
+
+    // The found Pokemon's pokenodes by pokemon_id. Finding a Pokemon
+    // only sets its found bit, and the Pokemon found since are added
+    // the next time found_order is needed.
+    IdOrder found_order;
+
+    // Arena that pokenodes (and Pokemon made by new_pokedex_pokemon)
+    // are allocated from, NULL if they are each malloced
+    Arena arena;
+    struct pokenode *free_nodes; // Removed pokenodes ready to be reused
+    int heap_pokemon; // Number of Pokemon stored that are not from arena
+
+    // Long names of the Pokemon made by new_pokedex_pokemon, shared with
+    // their clones (e.g. the Pokemon in get_pokemon_of_type's result),
+    // NULL until the first one is made
+    NamePool name_pool;
+
+    struct pokedex_columns columns;
+
+    // Grams of the names by slot, built by the first search_pokemon call
+    // (or the first after the columns are compacted) and kept up to date
+    // from then on, NULL until then
+    NameIndex name_index;
+
+    // Open-addressing (linear probing) index from pokemon_id to pokenode
+    struct id_slot *id_table;
+    int id_capacity; // Always zero or a power of two
+    int id_count;
+
+    // Lock held by every public function of a Pokedex made by
+    // new_concurrent_pokedex (shared by those that only read it), NULL
+    // for any other Pokedex
+    pthread_rwlock_t *lock;
+
+    // Lock on found_order (and ordered_bits) for views that bring it up
+    // to date while holding lock shared, NULL unless lock is not NULL
+    pthread_rwlock_t *found_order_lock;
+
+    // Lock taken to build name_index by a search holding lock shared,
+    // NULL unless lock is not NULL
+    pthread_mutex_t *name_index_lock;
+
+    // Pool that bulk operations (large queries, exploring and
+    // destroying) are split across: the one given to set_task_pool if
+    // any, or else the Pokedex's own with pool_threads threads, made
+    // when it is first needed, or default_task_pool if pool_threads is 0
+    TaskPool shared_task_pool;
+    TaskPool own_task_pool;
+    int pool_threads;
+};
+
+// Layout of a file written by save_pokedex: this header, then one
+// snapshot_record per Pokemon in Pokedex order, then one
+// snapshot_evolution per evolution, then every name (each followed by
+// '\0'). Every field is in the byte order of the machine that wrote it,
+// and the sections stay 8 byte aligned so a mapped file can be read in
+// place.
+struct snapshot_header {
+    char magic[8];         // SNAPSHOT_MAGIC
+    uint32_t version;      // SNAPSHOT_VERSION
+    uint32_t record_size;  // sizeof(struct snapshot_record)
+    uint32_t n_records;
+    uint32_t n_evolutions;
+    uint64_t names_length;
+    int32_t selected_id;   // NO_SELECTED_ID if the Pokedex was empty
+    uint32_t unused;
+    uint64_t checksum;     // Of everything after the header
+};
+
+struct snapshot_record {
+    int32_t id;
+    uint32_t name_offset;  // Offset of the name in the names section
+    double height;
+    double weight;
+    uint8_t type1;
+    uint8_t type2;
+    uint8_t found;
+    uint8_t unused[5];
+};
+
+struct snapshot_evolution {
+    int32_t from_id;
+    int32_t to_id;
+};
+
+// One bucket of the pokemon_id index, empty when node is NULL
+struct id_slot {
+    int id;
+    struct pokenode *node;
 };
 
 struct pokenode {
     struct pokenode *next;
-    struct pokenode *evolution;
+    struct pokenode *prev;
+    struct pokenode *evolution; // The pokenode this one evolves into
+
+    // The pokenodes that evolve into this one, in Pokedex order, listed
+    // through their next_from and prev_from
+    struct pokenode *first_from;
+    struct pokenode *next_from;
+    struct pokenode *prev_from;
+    // First Pokemon of this one's evolution chain, found by following
+    // first_from back as far as it goes (this pokenode if it has none)
+    struct pokenode *chain_root;
 
     Pokemon         pokemon;
-    int selected;
-    int found;
+    int slot; // Index of the Pokemon in the Pokedex's columns
 };
 
 static void print_asterisks(char *name);
-static void add_pokemon_order(Pokedex pokedex, Pokemon pokemon, int id);
-static char char_to_lower(char character) ;
-static int text_in_name(char *name, char *text);
+static void detail_pokenode(Pokedex pokedex, struct pokenode *current_node);
+static void show_evolution_chain(Pokedex pokedex,
+    struct pokenode *current_node);
+static int next_evolution_id(struct pokenode *current_node);
+static int prev_evolution_id(struct pokenode *current_node);
+static void print_chain_pokemon(Pokedex pokedex, struct pokenode *node);
+static int evolves_into(struct pokenode *from, struct pokenode *to);
+static void set_evolution(struct pokenode *from, struct pokenode *to);
+static void update_chain_roots(struct pokenode *node);
+static void unlink_evolutions(struct pokenode *node);
+static void move_cursors_off(Pokedex pokedex, struct pokenode *node);
+static struct pokenode *cursor_node(PokedexCursor cursor);
+static int mark_found(Pokedex pokedex, struct pokenode *node);
+static void update_found_order(Pokedex pokedex);
+static void remove_pokenode(Pokedex pokedex, struct pokenode *node);
+static int take_pokemon(Pokedex pokedex, struct taken_pokemon *taken);
+static int compare_taken_ids(const void *first, const void *second);
+static int is_found(Pokedex pokedex, struct pokenode *node);
+static void add_found_clone(Pokedex pokedex, struct pokenode *node);
+static PokedexView view_found_between(Pokedex pokedex, int min_id, int max_id);
+static void append_to_view(void *node, void *view);
+static PokedexView view_pokemon_matching(Pokedex pokedex, pokemon_type first,
+    pokemon_type second, int need_both);
+static PokedexView new_view(int capacity);
+static void view_append(PokedexView view, struct pokenode *node);
+static Pokedex materialize_and_destroy(PokedexView view);
+static PokedexView view_searched(Pokedex pokedex, char *text);
+static PokedexView filter_in_parallel(Pokedex pokedex, int n_items,
+    int grain, query_filter filter, void *query);
+static void filter_chunk(void *filter, int chunk);
+static void filter_type_words(Pokedex pokedex, void *query, int first,
+    int last, PokedexView view);
+static void filter_candidates(Pokedex pokedex, void *query, int first,
+    int last, PokedexView view);
+static int valid_query_type(pokemon_type type);
+static NameIndex get_name_index(Pokedex pokedex);
+static NameIndex build_name_index(Pokedex pokedex);
+static void explore_sampled(Pokedex pokedex, int seed, int factor, int how_many);
+static int find_eligible(Pokedex pokedex, int factor, int *eligible);
+static void scan_chunk(void *scan, int chunk);
+static void explore_compatible(Pokedex pokedex, int seed, int factor,
+    int how_many);
+static int can_explore(Pokedex pokedex, int slot, int factor);
+static uint64_t next_random(uint64_t *state);
+static struct pokenode *new_pokenode(Pokedex pokedex, Pokemon pokemon);
+static void append_pokenode(Pokedex pokedex, struct pokenode *node);
+static void destroy_pokenode(Pokedex pokedex, struct pokenode *node);
+static void destroy_chunk(void *teardown, int chunk);
+static unsigned int hash_id(int id);
+static struct pokenode *index_lookup(Pokedex pokedex, int id);
+static int index_insert(Pokedex pokedex, int id, struct pokenode *node);
+static void index_remove(Pokedex pokedex, int id);
+static void index_grow(Pokedex pokedex);
+static void prefetch_index(Pokedex pokedex, int id);
+static void reserve_pokedex(Pokedex pokedex, int n_pokemon);
+static uint64_t snapshot_checksum(const unsigned char *bytes, size_t length);
+static Pokedex load_snapshot(const unsigned char *bytes, size_t length);
+static int valid_snapshot_record(const struct snapshot_record *record,
+    const char *names, uint64_t names_length);
+static void columns_append(Pokedex pokedex, struct pokenode *node);
+static void columns_remove(Pokedex pokedex, struct pokenode *node);
+static void columns_compact(Pokedex pokedex);
+static void columns_grow(struct pokedex_columns *columns);
+static void columns_free(struct pokedex_columns *columns);
+static int test_bit(uint64_t *bits, int slot);
+static void set_bit(uint64_t *bits, int slot);
+static int test_and_set_bit(uint64_t *bits, int slot);
+static void clear_bit(uint64_t *bits, int slot);
+static void read_lock(Pokedex pokedex);
+static void write_lock(Pokedex pokedex);
+static void unlock(Pokedex pokedex);
+static int count_chunks(Pokedex pokedex, int n_items, int grain);
+static int chunk_start(int n_items, int n_chunks, int chunk);
+static int count_processors(void);
+static void run_chunks(Pokedex pokedex, int n_chunks, task_function function,
+    void *arg);
+static TaskPool pokedex_task_pool(Pokedex pokedex);
 
 Pokedex new_pokedex(void) {
     Pokedex new_pokedex = malloc(sizeof (struct pokedex));
     assert(new_pokedex != NULL);
     new_pokedex->head = NULL;
+    new_pokedex->tail = NULL;
+    new_pokedex->selected = NULL;
+    new_pokedex->cursors = NULL;
+    new_pokedex->total = 0;
+    new_pokedex->found = 0;
+    new_pokedex->exploring_mode = EXPLORE_COMPATIBLE;
+    new_pokedex->found_order = new_id_order();
+    new_pokedex->arena = NULL;
+    new_pokedex->free_nodes = NULL;
+    new_pokedex->heap_pokemon = 0;
+    new_pokedex->name_pool = NULL;
+    new_pokedex->id_table = NULL;
+    new_pokedex->id_capacity = 0;
+    new_pokedex->id_count = 0;
+    new_pokedex->name_index = NULL;
+    new_pokedex->lock = NULL;
+    new_pokedex->found_order_lock = NULL;
+    new_pokedex->name_index_lock = NULL;
+    new_pokedex->shared_task_pool = NULL;
+    new_pokedex->own_task_pool = NULL;
+    new_pokedex->pool_threads = 0;
+
+    struct pokedex_columns *columns = &new_pokedex->columns;
+    columns->length = 0;
+    columns->capacity = 0;
+    columns->holes = 0;
+    columns->node = NULL;
+    columns->found_bits = NULL;
+    columns->ordered_bits = NULL;
+    int type = 0;
+    while (type < MAX_TYPE) {
+        columns->type_bits[type] = NULL;
+        type += 1;
+    }
     return new_pokedex;
 }
 
+// Creates a Pokedex whose memory comes from an arena
+Pokedex new_arena_pokedex(void) {
+    Pokedex pokedex = new_pokedex();
+    pokedex->arena = new_arena();
+    return pokedex;
+}
+
+// Creates a Pokedex that many threads can use at once
+Pokedex new_concurrent_pokedex(void) {
+    Pokedex pokedex = new_pokedex();
+    pokedex->lock = malloc(sizeof (pthread_rwlock_t));
+    assert(pokedex->lock != NULL);
+    pokedex->found_order_lock = malloc(sizeof (pthread_rwlock_t));
+    assert(pokedex->found_order_lock != NULL);
+    pokedex->name_index_lock = malloc(sizeof (pthread_mutex_t));
+    assert(pokedex->name_index_lock != NULL);
+    if (pthread_rwlock_init(pokedex->lock, NULL) != 0 ||
+        pthread_rwlock_init(pokedex->found_order_lock, NULL) != 0 ||
+        pthread_mutex_init(pokedex->name_index_lock, NULL) != 0) {
+        fprintf(stderr, "Cannot create Pokedex lock.\n");
+        exit(1);
+    }
+    return pokedex;
+}
+
+// Creates a Pokemon using the Pokedex's arena if it has one, with its
+// name interned in the Pokedex's name pool
+Pokemon new_pokedex_pokemon(Pokedex pokedex, int pokemon_id, char *name,
+    double height, double weight, pokemon_type type1, pokemon_type type2) {
+
+    write_lock(pokedex);
+    if (pokedex->name_pool == NULL) {
+        pokedex->name_pool = new_name_pool();
+    }
+    Pokemon pokemon = new_interned_pokemon(pokedex->arena,
+        pokedex->name_pool, pokemon_id, name, height, weight, type1, type2);
+    unlock(pokedex);
+    return pokemon;
+}
+
 ////////////////////////////////////////////////////////////////////////
 //                         Stage 1 Functions                          //
 ////////////////////////////////////////////////////////////////////////
 
 // Adds Pokemon to the end of the Pokedex
 void add_pokemon(Pokedex pokedex, Pokemon pokemon) {
+    write_lock(pokedex);
+    // If pokemon_id is already indexed, it is already in the Pokedex
+    if (index_lookup(pokedex, pokemon_id(pokemon)) != NULL) {
+        fprintf(stderr, "Pokemon already in Pokedex!\n");
+        exit(1);
+    }
+
     // Allocate memory to pokenode n
-    struct pokenode *n = malloc(sizeof(struct pokenode));
-    assert (n != NULL); // exits if no memory has been allocated
-    
-    // Sets the starting conditions of the pokenode
-    n->pokemon = pokemon;
-    n->selected = 0;
-    n->found = 0;
-    n->next = NULL;
-    n->evolution = NULL;
-    
-    // If head is NULL, the Pokedex is currently empty
-    if (pokedex->head == NULL) {
-        n->selected = 1;
-        pokedex->head = n;
-    } else { // Pokedex is not empty, add Pokemon to end of the Pokedex
-        struct pokenode *current_node = pokedex->head;
-        struct pokenode *previous = NULL;
-        while (current_node != NULL) {
-            // if pokemon_id are the same, it is already in the Pokedex
-            if (pokemon_id(current_node->pokemon) == pokemon_id(n->pokemon)){
-                fprintf(stderr, "Pokemon already in Pokedex!\n");
-                exit(1);
-            }
-            previous = current_node;
-            current_node = current_node->next;
+    struct pokenode *n = new_pokenode(pokedex, pokemon);
+    index_insert(pokedex, pokemon_id(pokemon), n);
+    append_pokenode(pokedex, n);
+    unlock(pokedex);
+}
+
+// Adds many Pokemon to the end of the Pokedex in order, making room for
+// all of them first
+void add_pokemon_bulk(Pokedex pokedex, Pokemon *pokemon, int n_pokemon) {
+    write_lock(pokedex);
+    reserve_pokedex(pokedex, n_pokemon);
+
+    int i = 0;
+    while (i < n_pokemon) {
+        if (i + LOAD_PREFETCH_DISTANCE < n_pokemon) {
+            prefetch_index(pokedex, pokemon_id(pokemon[i + LOAD_PREFETCH_DISTANCE]));
         }
-        // Adds on pokemon to end of the Pokedex
-        previous->next = n;
-        current_node = n;
-        
-        // Sets the head of the pokedex to be selected
-        if (current_node == pokedex->head) {
-            current_node->selected = 1;
+        // Adding to the index checks for a duplicate in the same probe
+        struct pokenode *n = new_pokenode(pokedex, pokemon[i]);
+        if (!index_insert(pokedex, pokemon_id(pokemon[i]), n)) {
+            fprintf(stderr, "Pokemon already in Pokedex!\n");
+            exit(1);
         }
+        append_pokenode(pokedex, n);
+        i += 1;
     }
+    unlock(pokedex);
 }
 
 // Prints out all the details of the currently selected pokemon
 void detail_pokemon(Pokedex pokedex) {
-    struct pokenode *current_node = pokedex->head;
-    // Finds the currently selected Pokemon
-    while (current_node->selected != 1) {
-        current_node = current_node->next;
-    }
-    printf("Id: %03d\n", pokemon_id(current_node->pokemon));
-    
-    // Prints out all the information if the Pokemon is found
-    if (current_node->found == 1) {
-        printf("Name: %s\n", pokemon_name(current_node->pokemon));
-        printf("Height: %.1lfm\n", pokemon_height(current_node->pokemon));
-        printf("Weight: %.1lfkg\n", pokemon_weight(current_node->pokemon));
-        if (pokemon_first_type(current_node->pokemon) == NONE_TYPE) {
-            fprintf(stderr, "Type 1 cannot be none type.\n");
-            exit(1);
-        } else if (pokemon_first_type(current_node->pokemon) == pokemon_second_type(current_node->pokemon)) {
-            fprintf(stderr, "Type 1 is the same as type 2.\n");
-            exit(1);
-        } else if (pokemon_second_type(current_node->pokemon) == NONE_TYPE) {
-            printf("Type: %s\n", pokemon_type_to_string(pokemon_first_type(current_node->pokemon)));
-        } else {
-            printf("Type: %s %s\n", pokemon_type_to_string(pokemon_first_type(current_node->pokemon)), pokemon_type_to_string(pokemon_second_type(current_node->pokemon)));
-        }
-    } else { // Prints out all the information if the Pokemon has not yet been found
-        char *name = pokemon_name(current_node->pokemon);
-        printf("Name: ");
-        print_asterisks(name);
-        printf("\n");
-        printf("Height: --\n");
-        printf("Weight: --\n");
-        printf("Type: --\n");
-    }
+    read_lock(pokedex);
+    detail_pokenode(pokedex, pokedex->selected);
+    unlock(pokedex);
 }
 
 // Returns the pokemon struct of the currently selected Pokemon
 Pokemon get_current_pokemon(Pokedex pokedex) {
+    read_lock(pokedex);
     // If the Pokedex is not empty
-    if (pokedex->head != NULL) {
-        struct pokenode *current_node = pokedex->head;
-        while (current_node->selected != 1) {
-            current_node = current_node->next;
-        }
-        // Current node is currently selected Pokemon
-        return current_node->pokemon;
+    if (pokedex->selected != NULL) {
+        Pokemon pokemon = pokedex->selected->pokemon;
+        unlock(pokedex);
+        return pokemon;
     } else {
         fprintf(stderr, "Pokedex is currently empty!\n");
         exit(1);
@@ -131,28 +477,41 @@ Pokemon get_current_pokemon(Pokedex pokedex) {
 
 // Sets currently selected Pokemon to be 'found'
 void find_current_pokemon(Pokedex pokedex) {
-    if (pokedex->head != NULL) {
-        struct pokenode *current_node = pokedex->head;
-        while (current_node->selected != 1) {
-            current_node = current_node->next;
-        }
-        current_node->found = 1;
+    // Finding only sets a bit, which other threads can do at once
+    read_lock(pokedex);
+    if (pokedex->selected != NULL) {
+        mark_found(pokedex, pokedex->selected);
+    }
+    unlock(pokedex);
+}
+
+// Sets the Pokemon with pokemon_id = id to be 'found', returning 1 if
+// it is in the Pokedex
+int find_pokemon_by_id(Pokedex pokedex, int id) {
+    // Only writers change the index, so it can be read under the read lock
+    read_lock(pokedex);
+    struct pokenode *node = index_lookup(pokedex, id);
+    if (node != NULL) {
+        mark_found(pokedex, node);
     }
+    unlock(pokedex);
+    return node != NULL;
 }
 
 // Prints out each Pokemon in the Pokedex in order of when they were added
 void print_pokemon(Pokedex pokedex) {
+    read_lock(pokedex);
     struct pokenode *current_node = pokedex->head;
     while (current_node != NULL) {
         // Prints an arrow for the selected Pokemon
-        if (current_node->selected == 1) {
+        if (current_node == pokedex->selected) {
             printf("--> ");
         } else {
             printf("    ");
         }
         printf("#%03d: ", pokemon_id(current_node->pokemon));
         // Prints the name if found
-        if (current_node->found == 1) {
+        if (is_found(pokedex, current_node)) {
             printf("%s", pokemon_name(current_node->pokemon));
         } else {
             // Prints asterisks equivalent to name length if not found
@@ -161,6 +520,7 @@ void print_pokemon(Pokedex pokedex) {
         printf("\n");
         current_node = current_node->next;
     }
+    unlock(pokedex);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -169,126 +529,110 @@ void print_pokemon(Pokedex pokedex) {
 
 // Moves currently selected Pokemon to the next Pokemon in the Pokedex
 void next_pokemon(Pokedex pokedex) {
-    if (pokedex->head != NULL) {
-        struct pokenode *current_node = pokedex->head;
-        while (current_node->selected != 1) {
-            current_node = current_node->next;
-        }
-        current_node->selected = 0;
-        // Selected Pokemon remains the same if the function is called at
-        // the end of the Pokedex
-        if (current_node->next == NULL) {
-            current_node->selected = 1;
-        } else {
-            current_node->next->selected = 1;
-        }
+    // Selected Pokemon remains the same if the function is called at
+    // the end of the Pokedex
+    write_lock(pokedex);
+    if (pokedex->selected != NULL && pokedex->selected->next != NULL) {
+        pokedex->selected = pokedex->selected->next;
     }
+    unlock(pokedex);
 }
 
 // Moves currently selected Pokemon to the previous Pokemon in the Pokedex
 void prev_pokemon(Pokedex pokedex) {
-    if (pokedex->head != NULL) {
-        struct pokenode *current_node = pokedex->head;
-        struct pokenode *previous = NULL;
-        while (current_node->selected != 1) {
-            previous = current_node;
-            current_node = current_node->next;
-        }
-        current_node->selected = 0;
-        // Selected Pokemon remains the same if the function is called at
-        // the end of the Pokedex
-        if (previous == NULL) {
-            current_node->selected = 1;
-        } else {
-            previous->selected = 1;
-        }
+    // Selected Pokemon remains the same if the function is called at
+    // the start of the Pokedex
+    write_lock(pokedex);
+    if (pokedex->selected != NULL && pokedex->selected->prev != NULL) {
+        pokedex->selected = pokedex->selected->prev;
     }
+    unlock(pokedex);
 }
 
 // Changes currently selected Pokemon to that with pokemon_id = id
 void change_current_pokemon(Pokedex pokedex, int id) {
-    struct pokenode *current = pokedex->head;
-    struct pokenode *prev_selected = NULL;
-    int changed_selected = 0;
-    // Finds currently selected Pokemon
-    while (current != NULL) {
-        if (current->selected == 1) {
-            current->selected = 0;
-            prev_selected = current;
-        }
-        if (pokemon_id(current->pokemon) == id) {
-            current->selected = 1;
-            changed_selected = 1;
-        }
-        current = current->next;
-    }
-    // If there is no cange required (i.e. id same as currently selected)
-    if (changed_selected == 0) {
-        prev_selected->selected = 1;
+    write_lock(pokedex);
+    struct pokenode *target = index_lookup(pokedex, id);
+    // No Pokemon with that ID, currently selected Pokemon is unchanged
+    if (target != NULL) {
+        pokedex->selected = target;
     }
+    unlock(pokedex);
 }
 
 // Removes currently selected Pokemon from Pokedex
 void remove_pokemon(Pokedex pokedex) {
+    write_lock(pokedex);
     // If Pokedex is not empty
-    if (pokedex->head != NULL) {
-        struct pokenode *current_node = pokedex->head;
-        struct pokenode *previous = NULL;
-        // Finds currently selected Pokemon
-        while (current_node->selected != 1) {
-            previous = current_node;
-            current_node = current_node->next;
-        }
-        // Currently selected is the head of the Pokedex
-        if (current_node == pokedex->head) {
-            // Sets new head as the next pokenode before freeing the current head
-            pokedex->head = current_node->next;
-            free(pokemon_name(current_node->pokemon));
-            free(current_node->pokemon);
-            free(current_node);
-            // Sets new head as selected Pokemon if it exists
-            if (pokedex->head != NULL) {
-                pokedex->head->selected = 1;
-            }
-        // Currently selected is not the head of the Pokedex
-        } else {
-            // Skips over the currently selected pokenode
-            previous->next = current_node->next;
-            if (previous->next != NULL) {
-                previous->next->selected = 1;
-            } else {
-                previous->selected = 1;
-            }
-            free(pokemon_name(current_node->pokemon));
-            free(current_node->pokemon);
-            free(current_node);
-        } 
+    if (pokedex->selected != NULL) {
+        remove_pokenode(pokedex, pokedex->selected);
+    }
+    unlock(pokedex);
+}
+
+// Removes the Pokemon with pokemon_id = id from the Pokedex, returning 1
+// if it was in the Pokedex
+int remove_pokemon_by_id(Pokedex pokedex, int id) {
+    write_lock(pokedex);
+    struct pokenode *node = index_lookup(pokedex, id);
+    if (node != NULL) {
+        remove_pokenode(pokedex, node);
     }
+    unlock(pokedex);
+    return node != NULL;
 }
 
 // Destroys the pokedex and frees everything inside of it
 void destroy_pokedex(Pokedex pokedex) {
-    if (pokedex->head != NULL) {
+    // When everything came from the arena there is nothing to free one
+    // at a time, so the whole arena is released at once
+    // A Pokedex's own task pool is never made just to free memory
+    int n_chunks = 1;
+    if (pokedex->arena == NULL && (pokedex->shared_task_pool != NULL ||
+        pokedex->own_task_pool != NULL || pokedex->pool_threads <= 0)) {
+        n_chunks = count_chunks(pokedex, pokedex->columns.length,
+            TEARDOWN_GRAIN);
+    }
+    if (n_chunks > 1) {
+        // Malloced pokenodes are freed independently of each other, so
+        // a large Pokedex is freed a chunk of slots at a time
+        struct teardown teardown = {
+            pokedex, pokedex->columns.length, n_chunks
+        };
+        run_chunks(pokedex, n_chunks, destroy_chunk, &teardown);
+    } else if (pokedex->arena == NULL || pokedex->heap_pokemon > 0) {
         struct pokenode *current_node = pokedex->head;
-        struct pokenode *previous = NULL;
-        while (current_node->next != NULL) {
-            previous = current_node;
-            current_node = current_node->next;
-            if (previous != NULL) {
-                free(pokemon_name(previous->pokemon));
-                free(previous->pokemon);
-                free(previous);
-            }
-        }
-        if (current_node != NULL) {
-            free(pokemon_name(current_node->pokemon));
-            free(current_node->pokemon);
-            free(current_node);
+        while (current_node != NULL) {
+            struct pokenode *next = current_node->next;
+            destroy_pokenode(pokedex, current_node);
+            current_node = next;
         }
-        free(pokedex);
-    } else {
-        free(pokedex);
     }
+    if (pokedex->arena != NULL) {
+        destroy_arena(pokedex->arena);
+    }
+    // Clones of the Pokemon may still hold references to the pool
+    if (pokedex->name_pool != NULL) {
+        name_pool_release(pokedex->name_pool);
+    }
+    free(pokedex->id_table);
+    columns_free(&pokedex->columns);
+    if (pokedex->name_index != NULL) {
+        destroy_name_index(pokedex->name_index);
+    }
+    destroy_id_order(pokedex->found_order);
+    if (pokedex->lock != NULL) {
+        pthread_rwlock_destroy(pokedex->lock);
+        free(pokedex->lock);
+        pthread_rwlock_destroy(pokedex->found_order_lock);
+        free(pokedex->found_order_lock);
+        pthread_mutex_destroy(pokedex->name_index_lock);
+        free(pokedex->name_index_lock);
+    }
+    if (pokedex->own_task_pool != NULL) {
+        destroy_task_pool(pokedex->own_task_pool);
+    }
+    free(pokedex);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -297,69 +641,46 @@ void destroy_pokedex(Pokedex pokedex) {
 
 // Sets a certain number of random Pokemon to be found
 void go_exploring(Pokedex pokedex, int seed, int factor, int how_many) {
+    // Many threads can explore at once in EXPLORE_SAMPLED mode, but
+    // EXPLORE_COMPATIBLE mode draws from the one rand sequence
+    read_lock(pokedex);
+    if (pokedex->exploring_mode == EXPLORE_COMPATIBLE) {
+        unlock(pokedex);
+        write_lock(pokedex);
+    }
     if (pokedex->head != NULL) {
-        struct pokenode *current_node = pokedex->head;
-        int in_pokedex = 0; // Tells us whether there are enough Pokemon in the
-                            // Pokedex in the ID range given
-        while (current_node != NULL) {
-            if (pokemon_id(current_node->pokemon) >= 0 && 
-                pokemon_id(current_node->pokemon) <= (factor - 1) &&
-                current_node->found != 1){
-                
-                in_pokedex += 1;
-            }
-            current_node = current_node->next;
-        }
-        if (in_pokedex < how_many) {
-            fprintf(stderr, "No Pokemon with ID in that range.\n");
-            exit(1);
-        }
-        // Initialises the random number generator to the provided seed
-        srand(seed);
-        int i = 0;
-        while (i < how_many) {
-            int search_id = rand() % (factor); // Random search_id in range of
-                                               // 0 to factor - 1
-            current_node = pokedex->head;
-            while (current_node != NULL) {
-                if (search_id == pokemon_id(current_node->pokemon)
-                    && current_node->found != 1) {
-                    
-                    current_node->found = 1;
-                    i += 1;
-                }
-                current_node = current_node->next;
-            }
+        if (pokedex->exploring_mode == EXPLORE_COMPATIBLE) {
+            explore_compatible(pokedex, seed, factor, how_many);
+        } else {
+            explore_sampled(pokedex, seed, factor, how_many);
         }
+        unlock(pokedex);
     } else {
         fprintf(stderr, "No Pokemon in Pokedex.\n");
         exit(1);
     }
 }
 
+// Sets how go_exploring picks Pokemon
+void set_exploring_mode(Pokedex pokedex, exploring_mode mode) {
+    write_lock(pokedex);
+    pokedex->exploring_mode = mode;
+    unlock(pokedex);
+}
+
 // Returns the number of 'found' Pokemon in the Pokedex
 int count_found_pokemon(Pokedex pokedex) {
-    int num_found = 0;
-    struct pokenode *current_node = pokedex->head;
-    while (current_node != NULL) {
-        if (current_node->found == 1) {
-            num_found += 1;
-        }
-        current_node = current_node->next;
-    }
-    
-    return num_found;
+    read_lock(pokedex);
+    int found = __atomic_load_n(&pokedex->found, __ATOMIC_RELAXED);
+    unlock(pokedex);
+    return found;
 }
 
 // Returns the total number of Pokemon in the Pokedex
 int count_total_pokemon(Pokedex pokedex) {
-    int total = 0;
-    struct pokenode *current_node = pokedex->head;
-    while (current_node != NULL) {
-        total += 1;
-        current_node = current_node->next;
-    }
-    
+    read_lock(pokedex);
+    int total = pokedex->total;
+    unlock(pokedex);
     return total;
 }
 
@@ -373,83 +694,47 @@ void add_pokemon_evolution(Pokedex pokedex, int from_id, int to_id) {
         fprintf(stderr, "Same ID inputted.\n");
         exit(1);
     } else {
+        write_lock(pokedex);
         //Finding pokemon with ID equals to from_id and to_id
-        struct pokenode *current_node = pokedex->head;
-        struct pokenode *evolving_pokemon = NULL;
-        struct pokenode *evolution_pokemon = NULL;
-        while (current_node != NULL) {
-            if (pokemon_id(current_node->pokemon) == from_id) {
-                evolving_pokemon = current_node;
-            } else if (pokemon_id(current_node->pokemon) == to_id) {
-                evolution_pokemon = current_node;
-            }
-            current_node = current_node->next;
-        }
+        struct pokenode *evolving_pokemon = index_lookup(pokedex, from_id);
+        struct pokenode *evolution_pokemon = index_lookup(pokedex, to_id);
         // If we cannot find either Pokemon, prints an error
         if (evolving_pokemon == NULL || evolution_pokemon == NULL) {
             fprintf(stderr, "Cannot find Pokemon in Pokedex.\n");
             exit(1);
+        } else if (evolves_into(evolution_pokemon, evolving_pokemon)) {
+            fprintf(stderr, "Pokemon cannot evolve into itself.\n");
+            exit(1);
         } else {
             // Sets the evolution of Pokemon with from_id to the Pokemon with to_id
-            evolving_pokemon->evolution = evolution_pokemon;
+            set_evolution(evolving_pokemon, evolution_pokemon);
         }
+        unlock(pokedex);
     }
 }
 
-// Shows the evolution chain of the currently selected Pokemon
+// Shows the whole evolution chain of the currently selected Pokemon
 void show_evolutions(Pokedex pokedex) {
-    if (pokedex->head != NULL) {
-        struct pokenode *current_node = pokedex->head;
-        while (current_node->selected != 1) {// Finding selected pokemon
-            current_node = current_node->next;
-        }
-        if (current_node->found == 1) {
-            printf("#%03d ", pokemon_id(current_node->pokemon));
-            printf("%s ", pokemon_name(current_node->pokemon));
-            printf("[%s", pokemon_type_to_string(pokemon_first_type(current_node->pokemon)));
-            if (pokemon_second_type(current_node->pokemon) != NONE_TYPE) { // Check there is a second type
-                printf(", %s", pokemon_type_to_string(pokemon_first_type(current_node->pokemon)));
-            }
-            printf("] ");
-        } else {
-            printf("#%03d ???? [????] ", pokemon_id(current_node->pokemon));
-        }
-        while (current_node->evolution != NULL) { // Loop through until there is no next evolution
-            current_node = current_node->evolution;
-            if (current_node->found == 1) {
-                printf("--> #%03d ", pokemon_id(current_node->pokemon));
-                printf("%s ", pokemon_name(current_node->pokemon));
-                printf("[%s", pokemon_type_to_string(pokemon_first_type(current_node->pokemon)));
-                if (pokemon_second_type(current_node->pokemon) != NONE_TYPE) { // Check there is a second type
-                    printf(", %s", pokemon_type_to_string(pokemon_first_type(current_node->pokemon)));
-                }
-                printf("] ");
-            } else {
-                printf("--> #%03d ???? [????] ", pokemon_id(current_node->pokemon));
-            }
-        }
-        printf("\n");
-    }
+    read_lock(pokedex);
+    show_evolution_chain(pokedex, pokedex->selected);
+    unlock(pokedex);
 }
 
 // Returns the Pokemon_id of the next evolution of the currently selected Pokemon
 int get_next_evolution(Pokedex pokedex) {
-    if (pokedex->head != NULL) { // Check if pokedex is not empty
-        struct pokenode *current_node = pokedex->head;
-        //Goes through pokedex until the selected pokemon is reached
-        while (current_node->selected != 1) {
-            current_node = current_node->next;
-        }
-        if (current_node->evolution == NULL) { // No evolution
-            return DOES_NOT_EVOLVE;
-        } else {
-            // Returns pokemon ID of evolution
-            return pokemon_id(current_node->evolution->pokemon);
-        }
-    } else { // Pokedex is empty
-        fprintf(stderr, "Pokedex is empty.\n");
-        exit(1);
-    }
+    read_lock(pokedex);
+    int evolution_id = next_evolution_id(pokedex->selected);
+    unlock(pokedex);
+    return evolution_id;
+}
+
+// Returns the pokemon_id of a Pokemon that evolves into the currently
+// selected Pokemon
+int get_prev_evolution(Pokedex pokedex) {
+    read_lock(pokedex);
+    int evolution_id = prev_evolution_id(pokedex->selected);
+    unlock(pokedex);
+    return evolution_id;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -458,188 +743,1821 @@ int get_next_evolution(Pokedex pokedex) {
 
 // Makes a new Pokedex with Pokemon of the given type
 Pokedex get_pokemon_of_type(Pokedex pokedex, pokemon_type type) {
-    struct pokedex *new_type_pokedex = new_pokedex();
-    if (pokedex->head == NULL) {
-        // Returns an empty Pokedex
-        return new_type_pokedex;
-    } else if (type == NONE_TYPE || type == INVALID_TYPE || type == MAX_TYPE) {
-        fprintf(stderr, "Incorrect type name.");
-        exit(1);
-    // There are Pokemon in the Pokedex and the Type is valid
-    } else {
-        struct pokenode *current_node = pokedex->head;
-        while (current_node != NULL) {
-            // Adds a clone of the Pokemon if it is of the same type and is found
-            if ((pokemon_first_type(current_node->pokemon) == type ||
-                pokemon_second_type(current_node->pokemon) == type) &&
-                current_node->found == 1) {
-                
-                struct pokemon *clone = clone_pokemon(current_node->pokemon);
-                add_pokemon(new_type_pokedex, clone);
-            }
-            current_node = current_node->next;
-        }
-        current_node = new_type_pokedex->head;
-        // Sets all pokemon in new pokedex to be found
-        while (current_node != NULL) {
-            current_node->found = 1;
-            current_node = current_node->next;
-        }
-        return new_type_pokedex;
-    }
+    read_lock(pokedex);
+    Pokedex result = materialize_and_destroy(
+        view_pokemon_matching(pokedex, type, type, 1));
+    unlock(pokedex);
+    return result;
+}
+
+// Makes a new Pokedex with Pokemon that have both of the given types
+Pokedex get_pokemon_of_both_types(Pokedex pokedex, pokemon_type first,
+    pokemon_type second) {
+
+    read_lock(pokedex);
+    Pokedex result = materialize_and_destroy(
+        view_pokemon_matching(pokedex, first, second, 1));
+    unlock(pokedex);
+    return result;
+}
+
+// Makes a new Pokedex with Pokemon that have either of the given types
+Pokedex get_pokemon_of_either_type(Pokedex pokedex, pokemon_type first,
+    pokemon_type second) {
+
+    read_lock(pokedex);
+    Pokedex result = materialize_and_destroy(
+        view_pokemon_matching(pokedex, first, second, 0));
+    unlock(pokedex);
+    return result;
 }
 
 // Makes a new Pokedex including all the 'found' Pokemon
 Pokedex get_found_pokemon(Pokedex pokedex) {
-    struct pokedex *new_found_pokedex = new_pokedex();
-    if (pokedex->head == NULL) {
-        return new_found_pokedex; // Returns an empty pokedex
-    } else {
-        struct pokenode *current_node = pokedex->head;
-        while (current_node != NULL) {
-            if (current_node->found == 1) { // If current pokemon is found
-                struct pokemon *clone = clone_pokemon(current_node->pokemon);
-                add_pokemon_order(new_found_pokedex, clone, pokemon_id(clone));
-            }
-            current_node = current_node->next;
-        }
-        return new_found_pokedex;
-    }
+    read_lock(pokedex);
+    Pokedex result = materialize_and_destroy(
+        view_found_between(pokedex, 0, INT_MAX));
+    unlock(pokedex);
+    return result;
 }
 
 // Makes a new Pokedex with Pokemon that have "text" in their name
 Pokedex search_pokemon(Pokedex pokedex, char *text) {
-    struct pokedex *new_name_pokedex = new_pokedex();
-    if (pokedex->head == NULL) {
-        // Returns an empty pokedex
-        return new_name_pokedex;
-    } else {
-        struct pokenode *current_node = pokedex->head;
-        while (current_node != NULL) {
-            char *name = pokemon_name(current_node->pokemon);
-            // If current pokemon is found and the text is in their name
-            if (text_in_name(name, text) == 1 && current_node->found == 1) {
-                struct pokemon *clone = clone_pokemon(current_node->pokemon);
-                add_pokemon(new_name_pokedex, clone);
-                
-            }
-            current_node = current_node->next;
-        }
-        current_node = new_name_pokedex->head;
-        // Sets all pokemon in new pokedex to be found
-        while (current_node != NULL) {
-            current_node->found = 1;
-            current_node = current_node->next;
-        }
-        return new_name_pokedex;
-    }
+    read_lock(pokedex);
+    Pokedex result = materialize_and_destroy(view_searched(pokedex, text));
+    unlock(pokedex);
+    return result;
 }
 
-// [EXTRA FUNCTIONS] //
-
-// Prints asterisks to replace the Pokemon name
-static void print_asterisks(char *name) {
+// Moves the Pokemon of every Pokedex into a new one in order of
+// pokemon_id, then destroys them
+Pokedex merge_pokedexes(Pokedex *pokedexes, int n_pokedexes) {
+    int total = 0;
     int i = 0;
-    while (name[i] != '\0') {
-        printf("*");
+    while (i < n_pokedexes) {
+        total += pokedexes[i]->total;
+        i += 1;
+    }
+    struct taken_pokemon *taken = malloc((total + 1) *
+        sizeof(struct taken_pokemon));
+    assert(taken != NULL);
+    int n_taken = 0;
+    i = 0;
+    while (i < n_pokedexes) {
+        n_taken += take_pokemon(pokedexes[i], taken + n_taken);
+        destroy_pokedex(pokedexes[i]);
         i += 1;
     }
+    qsort(taken, n_taken, sizeof(struct taken_pokemon), compare_taken_ids);
+
+    Pokemon *pokemon = malloc((n_taken + 1) * sizeof(Pokemon));
+    assert(pokemon != NULL);
+    i = 0;
+    while (i < n_taken) {
+        pokemon[i] = taken[i].pokemon;
+        i += 1;
+    }
+    Pokedex merged = new_pokedex();
+    add_pokemon_bulk(merged, pokemon, n_taken);
+    // The new Pokedex's slots are in the order the Pokemon were added
+    i = 0;
+    while (i < n_taken) {
+        if (taken[i].found) {
+            mark_found(merged, merged->columns.node[i]);
+        }
+        i += 1;
+    }
+    free(pokemon);
+    free(taken);
+    return merged;
 }
 
-// Adds Pokemon in order of Pokemon ID
-static void add_pokemon_order(Pokedex pokedex, Pokemon pokemon, int id) {
-    struct pokenode *n = malloc(sizeof(struct pokenode));
-    assert (n != NULL);
-    n->pokemon = pokemon;
-    n->selected = 0;
-    n->found = 1;
-    n->evolution = NULL;
-    if (pokedex->head == NULL) {
-        n->selected = 1;
-        n->next = NULL;
+////////////////////////////////////////////////////////////////////////
+//                         Pokedex Views                              //
+////////////////////////////////////////////////////////////////////////
+
+// Views the found Pokemon of the given type
+PokedexView view_pokemon_of_type(Pokedex pokedex, pokemon_type type) {
+    read_lock(pokedex);
+    PokedexView view = view_pokemon_matching(pokedex, type, type, 1);
+    unlock(pokedex);
+    return view;
+}
+
+// Views the found Pokemon that have both of the given types
+PokedexView view_pokemon_of_both_types(Pokedex pokedex, pokemon_type first,
+    pokemon_type second) {
+
+    read_lock(pokedex);
+    PokedexView view = view_pokemon_matching(pokedex, first, second, 1);
+    unlock(pokedex);
+    return view;
+}
+
+// Views the found Pokemon that have either of the given types
+PokedexView view_pokemon_of_either_type(Pokedex pokedex, pokemon_type first,
+    pokemon_type second) {
+
+    read_lock(pokedex);
+    PokedexView view = view_pokemon_matching(pokedex, first, second, 0);
+    unlock(pokedex);
+    return view;
+}
+
+// Views all the 'found' Pokemon in order of pokemon_id
+PokedexView view_found_pokemon(Pokedex pokedex) {
+    read_lock(pokedex);
+    PokedexView view = view_found_between(pokedex, 0, INT_MAX);
+    unlock(pokedex);
+    return view;
+}
+
+// Views the 'found' Pokemon with pokemon_id from min_id to max_id
+PokedexView view_found_pokemon_in_range(Pokedex pokedex, int min_id,
+    int max_id) {
+
+    read_lock(pokedex);
+    PokedexView view = view_found_between(pokedex, min_id, max_id);
+    unlock(pokedex);
+    return view;
+}
+
+// Views the found Pokemon that have "text" in their name
+PokedexView view_search_pokemon(Pokedex pokedex, char *text) {
+    read_lock(pokedex);
+    PokedexView view = view_searched(pokedex, text);
+    unlock(pokedex);
+    return view;
+}
+
+// Returns the number of Pokemon in the view
+int view_count(PokedexView view) {
+    return view->length;
+}
+
+// Returns the Pokemon selected in the view
+Pokemon view_current_pokemon(PokedexView view) {
+    if (view->length == 0) {
+        fprintf(stderr, "Pokedex view is empty!\n");
+        exit(1);
+    }
+    return view->nodes[view->selected]->pokemon;
+}
+
+// Moves the view's selected Pokemon to the next one in the view
+void view_next_pokemon(PokedexView view) {
+    if (view->selected + 1 < view->length) {
+        view->selected += 1;
+    }
+}
+
+// Moves the view's selected Pokemon to the previous one in the view
+void view_prev_pokemon(PokedexView view) {
+    if (view->selected > 0) {
+        view->selected -= 1;
+    }
+}
+
+// Prints out the Pokemon in the view
+void print_view(PokedexView view) {
+    int i = 0;
+    while (i < view->length) {
+        // Prints an arrow for the selected Pokemon
+        if (i == view->selected) {
+            printf("--> ");
+        } else {
+            printf("    ");
+        }
+        Pokemon pokemon = view->nodes[i]->pokemon;
+        printf("#%03d: %s\n", pokemon_id(pokemon), pokemon_name(pokemon));
+        i += 1;
+    }
+}
+
+// Makes a new Pokedex with found copies of the Pokemon in the view
+Pokedex materialize_view(PokedexView view) {
+    Pokedex pokedex = new_pokedex();
+    int i = 0;
+    while (i < view->length) {
+        add_found_clone(pokedex, view->nodes[i]);
+        i += 1;
+    }
+    return pokedex;
+}
+
+// Frees the view, leaving its Pokemon alone
+void destroy_view(PokedexView view) {
+    free(view->nodes);
+    free(view);
+}
+
+////////////////////////////////////////////////////////////////////////
+//                         Snapshots                                  //
+////////////////////////////////////////////////////////////////////////
+
+// Writes the Pokedex to a snapshot file, returning 1 on success
+int save_pokedex(Pokedex pokedex, char *path) {
+    read_lock(pokedex);
+    int n_evolutions = 0;
+    struct pokenode *current_node = pokedex->head;
+    while (current_node != NULL) {
+        if (current_node->evolution != NULL) {
+            n_evolutions += 1;
+        }
+        current_node = current_node->next;
+    }
+
+    // Lays out everything after the header in one buffer, so the
+    // checksum can be taken before anything is written
+    struct pokedex_columns *columns = &pokedex->columns;
+    size_t records_size = pokedex->total * sizeof(struct snapshot_record);
+    size_t evolutions_size = n_evolutions * sizeof(struct snapshot_evolution);
+    size_t names_length = 0;
+    current_node = pokedex->head;
+    while (current_node != NULL) {
+        names_length += strlen(pokemon_name(current_node->pokemon)) + 1;
+        current_node = current_node->next;
+    }
+    size_t body_size = records_size + evolutions_size + names_length;
+    unsigned char *body = calloc(body_size + 1, 1);
+    assert(body != NULL);
+    struct snapshot_record *records = (struct snapshot_record *) body;
+    struct snapshot_evolution *evolutions =
+        (struct snapshot_evolution *) (body + records_size);
+    char *names = (char *) (body + records_size + evolutions_size);
+
+    int i = 0;
+    int evolution = 0;
+    size_t name_offset = 0;
+    current_node = pokedex->head;
+    while (current_node != NULL) {
+        Pokemon pokemon = current_node->pokemon;
+        records[i].id = pokemon_id(pokemon);
+        records[i].name_offset = name_offset;
+        records[i].height = pokemon_height(pokemon);
+        records[i].weight = pokemon_weight(pokemon);
+        records[i].type1 = pokemon_first_type(pokemon);
+        records[i].type2 = pokemon_second_type(pokemon);
+        records[i].found = test_bit(columns->found_bits, current_node->slot);
+        char *name = pokemon_name(pokemon);
+        size_t name_length = strlen(name);
+        memcpy(names + name_offset, name, name_length + 1);
+        name_offset += name_length + 1;
+        if (current_node->evolution != NULL) {
+            evolutions[evolution].from_id = pokemon_id(pokemon);
+            evolutions[evolution].to_id = pokemon_id(current_node->evolution->pokemon);
+            evolution += 1;
+        }
+        i += 1;
+        current_node = current_node->next;
+    }
+
+    struct snapshot_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.record_size = sizeof(struct snapshot_record);
+    header.n_records = pokedex->total;
+    header.n_evolutions = n_evolutions;
+    header.names_length = names_length;
+    header.selected_id = NO_SELECTED_ID;
+    if (pokedex->selected != NULL) {
+        header.selected_id = pokemon_id(pokedex->selected->pokemon);
+    }
+    header.checksum = snapshot_checksum(body, body_size);
+    unlock(pokedex);
+
+    // Replaces the old snapshot only once the new one is complete
+    char *temporary_path = malloc(strlen(path) + sizeof(".tmp"));
+    assert(temporary_path != NULL);
+    strcpy(temporary_path, path);
+    strcat(temporary_path, ".tmp");
+    FILE *file = fopen(temporary_path, "wb");
+    int saved = 0;
+    if (file != NULL) {
+        saved = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(body, 1, body_size, file) == body_size;
+        saved = fclose(file) == 0 && saved;
+        saved = saved && rename(temporary_path, path) == 0;
+        if (!saved) {
+            remove(temporary_path);
+        }
+    }
+    free(temporary_path);
+    free(body);
+    return saved;
+}
+
+// Maps a snapshot file into memory and loads a Pokedex from it
+Pokedex load_pokedex(char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 ||
+        status.st_size < (off_t) sizeof(struct snapshot_header)) {
+        close(fd);
+        return NULL;
+    }
+    size_t length = status.st_size;
+    void *bytes = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (bytes == MAP_FAILED) {
+        return NULL;
+    }
+    Pokedex pokedex = load_snapshot(bytes, length);
+    munmap(bytes, length);
+    return pokedex;
+}
+
+////////////////////////////////////////////////////////////////////////
+//                         Compact Records                            //
+////////////////////////////////////////////////////////////////////////
+
+// Packs every Pokemon into a malloced array, or returns -1 if one of
+// them does not fit in a record
+int pack_pokedex(Pokedex pokedex, CompactPokemon **records) {
+    read_lock(pokedex);
+    *records = malloc((pokedex->total + 1) * sizeof(CompactPokemon));
+    assert(*records != NULL);
+    int n_records = 0;
+    struct pokenode *current_node = pokedex->head;
+    while (current_node != NULL) {
+        if (!pack_pokemon(current_node->pokemon, &(*records)[n_records])) {
+            free(*records);
+            *records = NULL;
+            unlock(pokedex);
+            return -1;
+        }
+        n_records += 1;
+        current_node = current_node->next;
+    }
+    unlock(pokedex);
+    return n_records;
+}
+
+// Creates an arena Pokedex of the Pokemon in the records
+Pokedex unpack_pokedex(CompactPokemon *records, int n_records) {
+    Pokedex pokedex = new_arena_pokedex();
+    Pokemon *pokemon = malloc((n_records + 1) * sizeof(Pokemon));
+    assert(pokemon != NULL);
+    int i = 0;
+    while (i < n_records) {
+        CompactPokemon *record = &records[i];
+        pokemon[i] = new_pokedex_pokemon(pokedex, record->pokemon_id,
+            record->name, compact_pokemon_height(record),
+            compact_pokemon_weight(record), compact_pokemon_first_type(record),
+            compact_pokemon_second_type(record));
+        i += 1;
+    }
+    add_pokemon_bulk(pokedex, pokemon, n_records);
+    free(pokemon);
+    return pokedex;
+}
+
+////////////////////////////////////////////////////////////////////////
+//                         Pokedex Cursors                            //
+////////////////////////////////////////////////////////////////////////
+
+// Creates a cursor selecting the first Pokemon in the Pokedex
+PokedexCursor new_pokedex_cursor(Pokedex pokedex) {
+    PokedexCursor cursor = malloc(sizeof (struct pokedex_cursor));
+    assert(cursor != NULL);
+    write_lock(pokedex);
+    cursor->pokedex = pokedex;
+    cursor->node = pokedex->head;
+    cursor->prev = NULL;
+    cursor->next = pokedex->cursors;
+    if (pokedex->cursors != NULL) {
+        pokedex->cursors->prev = cursor;
+    }
+    pokedex->cursors = cursor;
+    unlock(pokedex);
+    return cursor;
+}
+
+// Returns the Pokemon selected by the cursor
+Pokemon cursor_current_pokemon(PokedexCursor cursor) {
+    read_lock(cursor->pokedex);
+    struct pokenode *current_node = cursor_node(cursor);
+    if (current_node != NULL) {
+        Pokemon pokemon = current_node->pokemon;
+        unlock(cursor->pokedex);
+        return pokemon;
+    } else {
+        fprintf(stderr, "Pokedex is currently empty!\n");
+        exit(1);
+    }
+}
+
+// Moves the cursor to the next Pokemon in the Pokedex
+void cursor_next_pokemon(PokedexCursor cursor) {
+    read_lock(cursor->pokedex);
+    struct pokenode *current_node = cursor_node(cursor);
+    if (current_node != NULL && current_node->next != NULL) {
+        cursor->node = current_node->next;
+    }
+    unlock(cursor->pokedex);
+}
+
+// Moves the cursor to the previous Pokemon in the Pokedex
+void cursor_prev_pokemon(PokedexCursor cursor) {
+    read_lock(cursor->pokedex);
+    struct pokenode *current_node = cursor_node(cursor);
+    if (current_node != NULL && current_node->prev != NULL) {
+        cursor->node = current_node->prev;
+    }
+    unlock(cursor->pokedex);
+}
+
+// Moves the cursor to the Pokemon with pokemon_id = id
+void cursor_change_pokemon(PokedexCursor cursor, int id) {
+    read_lock(cursor->pokedex);
+    struct pokenode *target = index_lookup(cursor->pokedex, id);
+    // No Pokemon with that ID, the cursor stays where it is
+    if (target != NULL) {
+        cursor->node = target;
+    }
+    unlock(cursor->pokedex);
+}
+
+// Prints out all the details of the Pokemon selected by the cursor
+void cursor_detail_pokemon(PokedexCursor cursor) {
+    read_lock(cursor->pokedex);
+    detail_pokenode(cursor->pokedex, cursor_node(cursor));
+    unlock(cursor->pokedex);
+}
+
+// Sets the Pokemon selected by the cursor to be 'found'
+void cursor_find_pokemon(PokedexCursor cursor) {
+    read_lock(cursor->pokedex);
+    struct pokenode *current_node = cursor_node(cursor);
+    if (current_node != NULL) {
+        mark_found(cursor->pokedex, current_node);
+    }
+    unlock(cursor->pokedex);
+}
+
+// Shows the evolution chain of the Pokemon selected by the cursor
+void cursor_show_evolutions(PokedexCursor cursor) {
+    read_lock(cursor->pokedex);
+    show_evolution_chain(cursor->pokedex, cursor_node(cursor));
+    unlock(cursor->pokedex);
+}
+
+// Returns the pokemon_id of the next evolution of the Pokemon selected
+// by the cursor
+int cursor_next_evolution(PokedexCursor cursor) {
+    read_lock(cursor->pokedex);
+    int evolution_id = next_evolution_id(cursor_node(cursor));
+    unlock(cursor->pokedex);
+    return evolution_id;
+}
+
+// Returns the pokemon_id of a Pokemon that evolves into the Pokemon
+// selected by the cursor
+int cursor_prev_evolution(PokedexCursor cursor) {
+    read_lock(cursor->pokedex);
+    int evolution_id = prev_evolution_id(cursor_node(cursor));
+    unlock(cursor->pokedex);
+    return evolution_id;
+}
+
+// Frees the cursor, leaving its Pokedex alone
+void destroy_pokedex_cursor(PokedexCursor cursor) {
+    Pokedex pokedex = cursor->pokedex;
+    write_lock(pokedex);
+    if (cursor->prev == NULL) {
+        pokedex->cursors = cursor->next;
+    } else {
+        cursor->prev->next = cursor->next;
+    }
+    if (cursor->next != NULL) {
+        cursor->next->prev = cursor->prev;
+    }
+    unlock(pokedex);
+    free(cursor);
+}
+
+////////////////////////////////////////////////////////////////////////
+//                         Task Pools                                 //
+////////////////////////////////////////////////////////////////////////
+
+// Sets how many threads the Pokedex's own task pool has
+void set_pool_threads(Pokedex pokedex, int n_threads) {
+    write_lock(pokedex);
+    // The pool is made again with the new size when next needed
+    if (pokedex->own_task_pool != NULL) {
+        destroy_task_pool(pokedex->own_task_pool);
+        pokedex->own_task_pool = NULL;
+    }
+    pokedex->pool_threads = n_threads;
+    unlock(pokedex);
+}
+
+// Makes bulk operations on the Pokedex use the given task pool
+void set_task_pool(Pokedex pokedex, TaskPool pool) {
+    write_lock(pokedex);
+    if (pool != NULL && pokedex->own_task_pool != NULL) {
+        destroy_task_pool(pokedex->own_task_pool);
+        pokedex->own_task_pool = NULL;
+    }
+    pokedex->shared_task_pool = pool;
+    unlock(pokedex);
+}
+
+// [EXTRA FUNCTIONS] //
+
+// Prints asterisks to replace the Pokemon name
+static void print_asterisks(char *name) {
+    int i = 0;
+    while (name[i] != '\0') {
+        printf("*");
+        i += 1;
+    }
+}
+
+// Prints out all the details of the Pokemon in the pokenode, if any
+static void detail_pokenode(Pokedex pokedex, struct pokenode *current_node) {
+    if (current_node == NULL) {
+        return;
+    }
+    printf("Id: %03d\n", pokemon_id(current_node->pokemon));
+    
+    // Prints out all the information if the Pokemon is found
+    if (is_found(pokedex, current_node)) {
+        printf("Name: %s\n", pokemon_name(current_node->pokemon));
+        printf("Height: %.1lfm\n", pokemon_height(current_node->pokemon));
+        printf("Weight: %.1lfkg\n", pokemon_weight(current_node->pokemon));
+        if (pokemon_first_type(current_node->pokemon) == NONE_TYPE) {
+            fprintf(stderr, "Type 1 cannot be none type.\n");
+            exit(1);
+        } else if (pokemon_first_type(current_node->pokemon) == pokemon_second_type(current_node->pokemon)) {
+            fprintf(stderr, "Type 1 is the same as type 2.\n");
+            exit(1);
+        } else if (pokemon_second_type(current_node->pokemon) == NONE_TYPE) {
+            printf("Type: %s\n", pokemon_type_to_string(pokemon_first_type(current_node->pokemon)));
+        } else {
+            printf("Type: %s %s\n", pokemon_type_to_string(pokemon_first_type(current_node->pokemon)), pokemon_type_to_string(pokemon_second_type(current_node->pokemon)));
+        }
+    } else { // Prints out all the information if the Pokemon has not yet been found
+        char *name = pokemon_name(current_node->pokemon);
+        printf("Name: ");
+        print_asterisks(name);
+        printf("\n");
+        printf("Height: --\n");
+        printf("Weight: --\n");
+        printf("Type: --\n");
+    }
+}
+
+// Shows the whole evolution chain of the Pokemon in the pokenode, if
+// any, from the first Pokemon of the chain on
+static void show_evolution_chain(Pokedex pokedex,
+    struct pokenode *current_node) {
+
+    if (current_node != NULL) {
+        current_node = current_node->chain_root;
+        print_chain_pokemon(pokedex, current_node);
+        while (current_node->evolution != NULL) { // Loop through until there is no next evolution
+            current_node = current_node->evolution;
+            printf("--> ");
+            print_chain_pokemon(pokedex, current_node);
+        }
+        printf("\n");
+    }
+}
+
+// Prints one Pokemon of an evolution chain, hiding its name and types
+// if it has not been found
+static void print_chain_pokemon(Pokedex pokedex, struct pokenode *node) {
+    if (is_found(pokedex, node)) {
+        printf("#%03d ", pokemon_id(node->pokemon));
+        printf("%s ", pokemon_name(node->pokemon));
+        printf("[%s", pokemon_type_to_string(pokemon_first_type(node->pokemon)));
+        if (pokemon_second_type(node->pokemon) != NONE_TYPE) { // Check there is a second type
+            printf(", %s", pokemon_type_to_string(pokemon_second_type(node->pokemon)));
+        }
+        printf("] ");
+    } else {
+        printf("#%03d ???? [????] ", pokemon_id(node->pokemon));
+    }
+}
+
+// Returns the pokemon_id of the next evolution of the Pokemon in the
+// pokenode, exiting if there is none because the Pokedex is empty
+static int next_evolution_id(struct pokenode *current_node) {
+    if (current_node != NULL) { // Check if pokedex is not empty
+        if (current_node->evolution == NULL) { // No evolution
+            return DOES_NOT_EVOLVE;
+        } else {
+            // Returns pokemon ID of evolution
+            return pokemon_id(current_node->evolution->pokemon);
+        }
+    } else { // Pokedex is empty
+        fprintf(stderr, "Pokedex is empty.\n");
+        exit(1);
+    }
+}
+
+// Returns the pokemon_id of the first Pokemon in Pokedex order that
+// evolves into the Pokemon in the pokenode, exiting if there is none
+// because the Pokedex is empty
+static int prev_evolution_id(struct pokenode *current_node) {
+    if (current_node == NULL) {
+        fprintf(stderr, "Pokedex is empty.\n");
+        exit(1);
+    } else if (current_node->first_from == NULL) {
+        return NO_PRE_EVOLUTION;
+    } else {
+        return pokemon_id(current_node->first_from->pokemon);
+    }
+}
+
+// Returns 1 if the Pokemon in `from` is, or evolves (directly or
+// through others) into, the Pokemon in `to`, 0 otherwise
+static int evolves_into(struct pokenode *from, struct pokenode *to) {
+    while (from != NULL) {
+        if (from == to) {
+            return 1;
+        }
+        from = from->evolution;
+    }
+    return 0;
+}
+
+// Makes `from` evolve into `to` instead of whatever it evolved into
+// before (or into nothing if `to` is NULL), keeping the lists of what
+// evolves into each pokenode and the chain roots up to date. `to` must
+// not evolve into `from`.
+static void set_evolution(struct pokenode *from, struct pokenode *to) {
+    struct pokenode *old = from->evolution;
+    if (old != NULL) {
+        if (from->prev_from == NULL) {
+            old->first_from = from->next_from;
+        } else {
+            from->prev_from->next_from = from->next_from;
+        }
+        if (from->next_from != NULL) {
+            from->next_from->prev_from = from->prev_from;
+        }
+        from->evolution = NULL;
+        update_chain_roots(old);
+    }
+    if (to != NULL) {
+        // Keeps the list in Pokedex (slot) order, so which Pokemon comes
+        // first does not depend on the order evolutions were added
+        struct pokenode *before = NULL;
+        struct pokenode *after = to->first_from;
+        while (after != NULL && after->slot < from->slot) {
+            before = after;
+            after = after->next_from;
+        }
+        from->prev_from = before;
+        from->next_from = after;
+        if (before == NULL) {
+            to->first_from = from;
+        } else {
+            before->next_from = from;
+        }
+        if (after != NULL) {
+            after->prev_from = from;
+        }
+        from->evolution = to;
+        update_chain_roots(to);
+    }
+}
+
+// Works out the chain root of the pokenode again after the first
+// Pokemon evolving into it has changed, and of every Pokemon it evolves
+// into, since only those can have it on the way back to their roots
+static void update_chain_roots(struct pokenode *node) {
+    while (node != NULL) {
+        if (node->first_from == NULL) {
+            node->chain_root = node;
+        } else {
+            node->chain_root = node->first_from->chain_root;
+        }
+        node = node->evolution;
+    }
+}
+
+// Removes every evolution into or out of the pokenode
+static void unlink_evolutions(struct pokenode *node) {
+    while (node->first_from != NULL) {
+        set_evolution(node->first_from, NULL);
+    }
+    set_evolution(node, NULL);
+}
+
+// Adds a clone of the pokenode's Pokemon to the end of the Pokedex, and
+// sets the clone to be found
+static void add_found_clone(Pokedex pokedex, struct pokenode *node) {
+    struct pokemon *clone = clone_pokemon(node->pokemon);
+    add_pokemon(pokedex, clone);
+    mark_found(pokedex, pokedex->tail);
+}
+
+// Views the found Pokemon that have both (if need_both is 1) or either
+// (if need_both is 0) of the given types
+static PokedexView view_pokemon_matching(Pokedex pokedex, pokemon_type first,
+    pokemon_type second, int need_both) {
+
+    if (pokedex->head == NULL) {
+        // Returns an empty view
+        return new_view(0);
+    } else if (!valid_query_type(first) || !valid_query_type(second)) {
+        fprintf(stderr, "Incorrect type name.");
+        exit(1);
+    }
+
+    struct pokedex_columns *columns = &pokedex->columns;
+    struct type_query query = {
+        columns->type_bits[first], columns->type_bits[second], need_both
+    };
+    int n_words = (columns->length + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    return filter_in_parallel(pokedex, n_words, TYPE_FILTER_GRAIN,
+        filter_type_words, &query);
+}
+
+// Views the found Pokemon with pokemon_id from min_id to max_id, in the
+// order the Pokedex keeps them
+static PokedexView view_found_between(Pokedex pokedex, int min_id, int max_id) {
+    PokedexView view = new_view(0);
+    if (pokedex->found_order_lock == NULL) {
+        update_found_order(pokedex);
+    } else {
+        // Only one view at a time can add Pokemon to found_order, but
+        // any number can walk it once nothing is missing from it
+        pthread_rwlock_rdlock(pokedex->found_order_lock);
+        if (id_order_count(pokedex->found_order) !=
+            __atomic_load_n(&pokedex->found, __ATOMIC_RELAXED)) {
+            pthread_rwlock_unlock(pokedex->found_order_lock);
+            pthread_rwlock_wrlock(pokedex->found_order_lock);
+            update_found_order(pokedex);
+            pthread_rwlock_unlock(pokedex->found_order_lock);
+            pthread_rwlock_rdlock(pokedex->found_order_lock);
+        }
+    }
+    id_order_visit(pokedex->found_order, min_id, max_id, append_to_view, view);
+    if (pokedex->found_order_lock != NULL) {
+        pthread_rwlock_unlock(pokedex->found_order_lock);
+    }
+    return view;
+}
+
+// Adds a pokenode to a view, for id_order_visit
+static void append_to_view(void *node, void *view) {
+    view_append(view, node);
+}
+
+// Creates an empty view with room for `capacity` Pokemon
+static PokedexView new_view(int capacity) {
+    PokedexView view = malloc(sizeof(struct pokedex_view));
+    assert(view != NULL);
+    view->nodes = NULL;
+    if (capacity > 0) {
+        view->nodes = malloc(capacity * sizeof(struct pokenode *));
+        assert(view->nodes != NULL);
+    }
+    view->length = 0;
+    view->capacity = capacity;
+    view->selected = 0;
+    return view;
+}
+
+// Adds the pokenode to the end of the view, doubling its space if full
+static void view_append(PokedexView view, struct pokenode *node) {
+    if (view->length == view->capacity) {
+        int capacity = view->capacity * 2;
+        if (capacity == 0) {
+            capacity = 16;
+        }
+        view->nodes = realloc(view->nodes, capacity * sizeof(struct pokenode *));
+        assert(view->nodes != NULL);
+        view->capacity = capacity;
+    }
+    view->nodes[view->length] = node;
+    view->length += 1;
+}
+
+// Makes a new Pokedex from the view, then frees the view
+static Pokedex materialize_and_destroy(PokedexView view) {
+    Pokedex pokedex = materialize_view(view);
+    destroy_view(view);
+    return pokedex;
+}
+
+// Views the found Pokemon that have "text" in their name
+static PokedexView view_searched(Pokedex pokedex, char *text) {
+    if (pokedex->head == NULL) {
+        // Returns an empty view
+        return new_view(0);
+    } else {
+        char *folded = NULL;
+        int folded_length = name_match_fold(text, &folded);
+        if (folded_length == 0) {
+            // No name can contain the text
+            return new_view(0);
+        }
+        // Only the Pokemon whose names have all of the text's grams can
+        // match, and they are checked in Pokedex order
+        int *candidates = NULL;
+        int n_candidates = name_index_candidates(get_name_index(pokedex),
+            text, &candidates);
+        struct search_query query = {candidates, folded, folded_length};
+        PokedexView view = filter_in_parallel(pokedex, n_candidates,
+            SEARCH_FILTER_GRAIN, filter_candidates, &query);
+        free(candidates);
+        free(folded);
+        return view;
+    }
+}
+
+// Views the matching items of a query, splitting them into chunks in
+// Pokedex order for the task pool when there are enough of them, and
+// joining the chunks' matches in the same order
+static PokedexView filter_in_parallel(Pokedex pokedex, int n_items,
+    int grain, query_filter filter, void *query) {
+
+    int n_chunks = count_chunks(pokedex, n_items, grain);
+    if (n_chunks == 1) {
+        PokedexView view = new_view(0);
+        filter(pokedex, query, 0, n_items, view);
+        return view;
+    }
+
+    PokedexView *views = malloc(n_chunks * sizeof(PokedexView));
+    assert(views != NULL);
+    struct chunked_filter chunked = {
+        pokedex, filter, query, n_items, n_chunks, views
+    };
+    run_chunks(pokedex, n_chunks, filter_chunk, &chunked);
+
+    int total = 0;
+    int i = 0;
+    while (i < n_chunks) {
+        total += views[i]->length;
+        i += 1;
+    }
+    PokedexView view = new_view(total);
+    i = 0;
+    while (i < n_chunks) {
+        int j = 0;
+        while (j < views[i]->length) {
+            view_append(view, views[i]->nodes[j]);
+            j += 1;
+        }
+        destroy_view(views[i]);
+        i += 1;
+    }
+    free(views);
+    return view;
+}
+
+// Filters one chunk of a query split by filter_in_parallel
+static void filter_chunk(void *filter, int chunk) {
+    struct chunked_filter *f = filter;
+    f->views[chunk] = new_view(0);
+    f->filter(f->pokedex, f->query, chunk_start(f->n_items, f->n_chunks,
+        chunk), chunk_start(f->n_items, f->n_chunks, chunk + 1),
+        f->views[chunk]);
+}
+
+// Views the found Pokemon in words first to last - 1 of a type_query's
+// bitsets. Combines the bitsets a word (64 Pokemon) at a time, so only
+// the matching Pokemon are ever looked at.
+static void filter_type_words(Pokedex pokedex, void *query, int first,
+    int last, PokedexView view) {
+
+    struct type_query *q = query;
+    struct pokedex_columns *columns = &pokedex->columns;
+    int word = first;
+    while (word < last) {
+        uint64_t bits = 0;
+        if (q->need_both) {
+            bits = q->first_bits[word] & q->second_bits[word];
+        } else {
+            bits = q->first_bits[word] | q->second_bits[word];
+        }
+        bits &= __atomic_load_n(&columns->found_bits[word], __ATOMIC_RELAXED);
+        while (bits != 0) {
+            int slot = word * BITS_PER_WORD + __builtin_ctzll(bits);
+            view_append(view, columns->node[slot]);
+            bits &= bits - 1;
+        }
+        word += 1;
+    }
+}
+
+// Views the found Pokemon among candidates first to last - 1 of a
+// search_query that have its text in their name
+static void filter_candidates(Pokedex pokedex, void *query, int first,
+    int last, PokedexView view) {
+
+    struct search_query *q = query;
+    struct pokedex_columns *columns = &pokedex->columns;
+    int i = first;
+    while (i < last) {
+        int slot = q->candidates[i];
+        // If current pokemon is found and the text is in their name
+        if (test_bit(columns->found_bits, slot)) {
+            char *name = pokemon_name(columns->node[slot]->pokemon);
+            if (name_match(name, strlen(name), q->folded, q->folded_length)) {
+                view_append(view, columns->node[slot]);
+            }
+        }
+        i += 1;
+    }
+}
+
+// Finds `how_many` distinct Pokemon chosen at random from those that
+// can be explored, by shuffling just the front of a list of them
+static void explore_sampled(Pokedex pokedex, int seed, int factor, int how_many) {
+    struct pokedex_columns *columns = &pokedex->columns;
+    int *eligible = malloc(columns->length * sizeof(int));
+    assert(eligible != NULL);
+    int n_eligible = find_eligible(pokedex, factor, eligible);
+    if (n_eligible < how_many) {
+        fprintf(stderr, "No Pokemon with ID in that range.\n");
+        exit(1);
+    }
+
+    // Another thread exploring at the same time may find a picked
+    // Pokemon first, in which case another is picked
+    uint64_t state = (uint64_t) seed;
+    int found = 0;
+    int i = 0;
+    while (found < how_many && i < n_eligible) {
+        // Swaps a random one of the Pokemon not yet picked into place i
+        int pick = i + next_random(&state) % (n_eligible - i);
+        int picked_slot = eligible[pick];
+        eligible[pick] = eligible[i];
+        eligible[i] = picked_slot;
+        found += mark_found(pokedex, columns->node[picked_slot]);
+        i += 1;
+    }
+    free(eligible);
+}
+
+// Fills eligible with the slots of the Pokemon that can be explored, in
+// slot order, returning how many there are. A large Pokedex is scanned
+// in chunks by the task pool, each chunk writing its slots from its own
+// first slot on, and the gaps between them are then closed up.
+static int find_eligible(Pokedex pokedex, int factor, int *eligible) {
+    int length = pokedex->columns.length;
+    int n_chunks = count_chunks(pokedex, length, EXPLORE_SCAN_GRAIN);
+    int *counts = malloc(n_chunks * sizeof(int));
+    assert(counts != NULL);
+    struct explore_scan scan = {
+        pokedex, factor, length, n_chunks, eligible, counts
+    };
+    run_chunks(pokedex, n_chunks, scan_chunk, &scan);
+    int n_eligible = 0;
+    int chunk = 0;
+    while (chunk < n_chunks) {
+        memmove(eligible + n_eligible,
+            eligible + chunk_start(length, n_chunks, chunk),
+            counts[chunk] * sizeof(int));
+        n_eligible += counts[chunk];
+        chunk += 1;
+    }
+    free(counts);
+    return n_eligible;
+}
+
+// Finds the slots that can be explored in one chunk of an explore_scan
+static void scan_chunk(void *scan, int chunk) {
+    struct explore_scan *s = scan;
+    int first = chunk_start(s->n_items, s->n_chunks, chunk);
+    int last = chunk_start(s->n_items, s->n_chunks, chunk + 1);
+    int count = 0;
+    int slot = first;
+    while (slot < last) {
+        if (can_explore(s->pokedex, slot, s->factor)) {
+            s->eligible[first + count] = slot;
+            count += 1;
+        }
+        slot += 1;
+    }
+    s->counts[chunk] = count;
+}
+
+// Finds Pokemon by drawing IDs from rand() until `how_many` new Pokemon
+// have been found, as go_exploring always has
+static void explore_compatible(Pokedex pokedex, int seed, int factor,
+    int how_many) {
+
+    struct pokedex_columns *columns = &pokedex->columns;
+    int in_pokedex = 0; // Tells us whether there are enough Pokemon in the
+                        // Pokedex in the ID range given
+    int slot = 0;
+    while (slot < columns->length) {
+        if (can_explore(pokedex, slot, factor)) {
+            in_pokedex += 1;
+        }
+        slot += 1;
+    }
+    if (in_pokedex < how_many) {
+        fprintf(stderr, "No Pokemon with ID in that range.\n");
+        exit(1);
+    }
+    // Initialises the random number generator to the provided seed
+    srand(seed);
+    int i = 0;
+    while (i < how_many) {
+        int search_id = rand() % (factor); // Random search_id in range of
+                                           // 0 to factor - 1
+        struct pokenode *node = index_lookup(pokedex, search_id);
+        if (node != NULL && mark_found(pokedex, node)) {
+            i += 1;
+        }
+    }
+}
+
+// Returns 1 if the Pokemon in the slot has not been found and has an ID
+// from 0 to factor - 1, 0 otherwise
+static int can_explore(Pokedex pokedex, int slot, int factor) {
+    struct pokedex_columns *columns = &pokedex->columns;
+    // Holes have no node so are never explored
+    if (columns->node[slot] == NULL || test_bit(columns->found_bits, slot)) {
+        return 0;
+    }
+    int id = pokemon_id(columns->node[slot]->pokemon);
+    return id >= 0 && id <= (factor - 1);
+}
+
+// Returns the next number from a splitmix64 generator
+static uint64_t next_random(uint64_t *state) {
+    *state += 0x9E3779B97F4A7C15u;
+    uint64_t z = *state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+    return z ^ (z >> 31);
+}
+
+// Returns 1 if Pokemon can be searched for by the type, 0 otherwise
+static int valid_query_type(pokemon_type type) {
+    return type != NONE_TYPE && type != INVALID_TYPE && type != MAX_TYPE;
+}
+
+// Returns the Pokedex's name index, building it if this is the first
+// search since it was made or compacted. Searches on a concurrent
+// Pokedex only hold its lock shared, so one of them builds the index
+// under name_index_lock while any others wait for it.
+static NameIndex get_name_index(Pokedex pokedex) {
+    NameIndex name_index = __atomic_load_n(&pokedex->name_index,
+        __ATOMIC_ACQUIRE);
+    if (name_index != NULL) {
+        return name_index;
+    }
+    if (pokedex->name_index_lock != NULL) {
+        pthread_mutex_lock(pokedex->name_index_lock);
+    }
+    name_index = __atomic_load_n(&pokedex->name_index, __ATOMIC_ACQUIRE);
+    if (name_index == NULL) {
+        name_index = build_name_index(pokedex);
+        __atomic_store_n(&pokedex->name_index, name_index, __ATOMIC_RELEASE);
+    }
+    if (pokedex->name_index_lock != NULL) {
+        pthread_mutex_unlock(pokedex->name_index_lock);
+    }
+    return name_index;
+}
+
+// Creates a name index from the names of all the Pokedex's Pokemon
+static NameIndex build_name_index(Pokedex pokedex) {
+    struct pokedex_columns *columns = &pokedex->columns;
+    NameIndex name_index = new_name_index();
+    int slot = 0;
+    while (slot < columns->length) {
+        if (columns->node[slot] != NULL) {
+            name_index_add(name_index, slot,
+                pokemon_name(columns->node[slot]->pokemon));
+        }
+        slot += 1;
+    }
+    return name_index;
+}
+
+// Makes room in the Pokedex's index and columns for `n_pokemon` more
+// Pokemon, so that adding them never has to grow anything
+static void reserve_pokedex(Pokedex pokedex, int n_pokemon) {
+    while (pokedex->id_capacity < (pokedex->id_count + n_pokemon + 1) * 2) {
+        index_grow(pokedex);
+    }
+    struct pokedex_columns *columns = &pokedex->columns;
+    while (columns->capacity < columns->length + n_pokemon) {
+        columns_grow(columns);
+    }
+}
+
+// Returns a checksum of the bytes, taking them eight at a time
+static uint64_t snapshot_checksum(const unsigned char *bytes, size_t length) {
+    uint64_t hash = 14695981039346656037u;
+    size_t i = 0;
+    while (i + sizeof(uint64_t) <= length) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(uint64_t));
+        hash = (hash ^ word) * 1099511628211u;
+        hash ^= hash >> 32;
+        i += sizeof(uint64_t);
+    }
+    while (i < length) {
+        hash = (hash ^ bytes[i]) * 1099511628211u;
+        i += 1;
+    }
+    return hash;
+}
+
+// Checks a mapped snapshot and builds an arena Pokedex from it, or
+// returns NULL if it is not a complete, valid snapshot
+static Pokedex load_snapshot(const unsigned char *bytes, size_t length) {
+    const struct snapshot_header *header = (const struct snapshot_header *) bytes;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        header->version != SNAPSHOT_VERSION ||
+        header->record_size != sizeof(struct snapshot_record) ||
+        header->n_records > INT_MAX / 2 || header->n_evolutions > INT_MAX ||
+        header->names_length > INT_MAX / 2) {
+        return NULL;
+    }
+    int n_records = header->n_records;
+    int n_evolutions = header->n_evolutions;
+    uint64_t records_size = (uint64_t) header->n_records *
+        sizeof(struct snapshot_record);
+    uint64_t evolutions_size = (uint64_t) header->n_evolutions *
+        sizeof(struct snapshot_evolution);
+    uint64_t body_size = records_size + evolutions_size + header->names_length;
+    if (body_size != length - sizeof(struct snapshot_header)) {
+        return NULL;
+    }
+    const unsigned char *body = bytes + sizeof(struct snapshot_header);
+    if (snapshot_checksum(body, body_size) != header->checksum) {
+        return NULL;
+    }
+    const struct snapshot_record *records = (const struct snapshot_record *) body;
+    const struct snapshot_evolution *evolutions =
+        (const struct snapshot_evolution *) (body + records_size);
+    const char *names = (const char *) (body + records_size + evolutions_size);
+
+    // Checks every record first, so that new_pokemon never has to exit
+    int i = 0;
+    while (i < n_records) {
+        if (!valid_snapshot_record(&records[i], names, header->names_length)) {
+            return NULL;
+        }
+        i += 1;
+    }
+
+    Pokedex pokedex = new_arena_pokedex();
+    reserve_pokedex(pokedex, n_records);
+    i = 0;
+    while (i < n_records) {
+        const struct snapshot_record *record = &records[i];
+        // Index buckets are scattered, so the bucket of a Pokemon a few
+        // records ahead is fetched while this one is added
+        if (i + LOAD_PREFETCH_DISTANCE < n_records) {
+            prefetch_index(pokedex, records[i + LOAD_PREFETCH_DISTANCE].id);
+        }
+        Pokemon pokemon = new_pokedex_pokemon(pokedex, record->id,
+            (char *) names + record->name_offset, record->height,
+            record->weight, record->type1, record->type2);
+        // Everything so far came from the arena, so destroying the
+        // Pokedex frees this Pokemon and pokenode too
+        struct pokenode *node = new_pokenode(pokedex, pokemon);
+        if (!index_insert(pokedex, record->id, node)) {
+            destroy_pokedex(pokedex);
+            return NULL;
+        }
+        append_pokenode(pokedex, node);
+        if (record->found) {
+            mark_found(pokedex, pokedex->tail);
+        }
+        i += 1;
+    }
+
+    i = 0;
+    while (i < n_evolutions) {
+        struct pokenode *from = index_lookup(pokedex, evolutions[i].from_id);
+        struct pokenode *to = index_lookup(pokedex, evolutions[i].to_id);
+        if (from == NULL || to == NULL || evolves_into(to, from)) {
+            destroy_pokedex(pokedex);
+            return NULL;
+        }
+        set_evolution(from, to);
+        i += 1;
+    }
+
+    if (header->selected_id != NO_SELECTED_ID) {
+        pokedex->selected = index_lookup(pokedex, header->selected_id);
+    }
+    if ((pokedex->selected == NULL) != (pokedex->head == NULL)) {
+        destroy_pokedex(pokedex);
+        return NULL;
+    }
+    return pokedex;
+}
+
+// Returns 1 if the record describes a Pokemon new_pokemon would accept,
+// with a valid name inside the names section, 0 otherwise
+static int valid_snapshot_record(const struct snapshot_record *record,
+    const char *names, uint64_t names_length) {
+
+    if (record->id < 0 || record->type1 == NONE_TYPE ||
+        record->type1 >= MAX_TYPE || record->type2 >= MAX_TYPE ||
+        record->type1 == record->type2 || record->found > 1 ||
+        record->name_offset >= names_length) {
+        return 0;
+    }
+    // The name must end inside the names section
+    const char *name = names + record->name_offset;
+    const char *end = memchr(name, '\0', names_length - record->name_offset);
+    return end != NULL && pokemon_valid_name((char *) name);
+}
+
+// Links a new pokenode in at the end of the Pokedex and gives it a slot
+// in the columns
+static void append_pokenode(Pokedex pokedex, struct pokenode *n) {
+    // Sets the starting conditions of the pokenode
+    n->next = NULL;
+    n->prev = NULL;
+    n->evolution = NULL;
+    n->first_from = NULL;
+    n->next_from = NULL;
+    n->prev_from = NULL;
+    n->chain_root = n;
+
+    // If head is NULL, the Pokedex is currently empty
+    if (pokedex->head == NULL) {
         pokedex->head = n;
+        pokedex->selected = n;
+    } else { // Pokedex is not empty, add Pokemon to end of the Pokedex
+        pokedex->tail->next = n;
+        n->prev = pokedex->tail;
+    }
+    pokedex->tail = n;
+    pokedex->total += 1;
+    columns_append(pokedex, n);
+}
+
+// Allocates a pokenode holding the Pokemon, from the Pokedex's arena if
+// it has one
+static struct pokenode *new_pokenode(Pokedex pokedex, Pokemon pokemon) {
+    struct pokenode *node = NULL;
+    if (pokedex->arena == NULL) {
+        node = malloc(sizeof(struct pokenode));
+        assert(node != NULL); // exits if no memory has been allocated
     } else {
-        struct pokenode *current_node = pokedex->head;
-        struct pokenode *previous = NULL;
-        // Loops until there is an ID reached that is greater than the given ID
-        // or until the end of the Pokedex is reached
-        while (id > pokemon_id(current_node->pokemon) && current_node->next != NULL) {
-            if (pokemon_id(current_node->pokemon) == id){
-                fprintf(stderr, "Pokemon already in Pokedex!\n");
-                exit(1);
-            }
-            previous = current_node;
-            current_node = current_node->next;
-        }
-        // While loop stopped due to being at end of linked list
-        if (id > pokemon_id(current_node->pokemon)) {
-            n->next = current_node->next;
-            current_node->next = n;
-        // If Pokemon is to be placed at start of new pokedex
-        } else if (current_node == pokedex->head) {
-            n->next = current_node;
-            current_node->selected = 0;
-            pokedex->head = n;
-            n->selected = 1;
-        // Somewhere in the middle of the Pokedex
+        // Keeps track of Pokemon which will need to be destroyed one at a
+        // time because their memory is not part of the arena
+        if (pokemon_arena(pokemon) != pokedex->arena) {
+            pokedex->heap_pokemon += 1;
+        }
+        // Reuses a removed pokenode if there is one
+        if (pokedex->free_nodes != NULL) {
+            node = pokedex->free_nodes;
+            pokedex->free_nodes = node->next;
+        } else {
+            node = arena_alloc(pokedex->arena, sizeof(struct pokenode));
+        }
+    }
+    node->pokemon = pokemon;
+    return node;
+}
+
+// Destroys the pokenode and its Pokemon
+static void destroy_pokenode(Pokedex pokedex, struct pokenode *node) {
+    if (pokedex->arena == NULL) {
+        destroy_pokemon(node->pokemon);
+        free(node);
+    } else {
+        if (pokemon_arena(node->pokemon) != pokedex->arena) {
+            pokedex->heap_pokemon -= 1;
+        }
+        destroy_pokemon(node->pokemon);
+        // Arena memory cannot be freed, so the pokenode is kept for reuse
+        node->next = pokedex->free_nodes;
+        pokedex->free_nodes = node;
+    }
+}
+
+// Destroys the malloced pokenodes in one chunk of slots of a teardown
+static void destroy_chunk(void *teardown, int chunk) {
+    struct teardown *t = teardown;
+    struct pokedex_columns *columns = &t->pokedex->columns;
+    int slot = chunk_start(t->n_items, t->n_chunks, chunk);
+    int last = chunk_start(t->n_items, t->n_chunks, chunk + 1);
+    while (slot < last) {
+        if (columns->node[slot] != NULL) {
+            destroy_pokenode(t->pokedex, columns->node[slot]);
+        }
+        slot += 1;
+    }
+}
+
+// Unlinks the pokenode from the Pokedex and frees it. If it was the
+// currently selected Pokemon, the one after it (or before it, at the
+// end) becomes selected.
+static void remove_pokenode(Pokedex pokedex, struct pokenode *node) {
+    index_remove(pokedex, pokemon_id(node->pokemon));
+
+    // Skips over the pokenode in both directions
+    if (node->prev == NULL) {
+        pokedex->head = node->next;
+    } else {
+        node->prev->next = node->next;
+    }
+    if (node->next == NULL) {
+        pokedex->tail = node->prev;
+    } else {
+        node->next->prev = node->prev;
+    }
+    pokedex->total -= 1;
+    if (is_found(pokedex, node)) {
+        pokedex->found -= 1;
+        id_order_remove(pokedex->found_order, pokemon_id(node->pokemon));
+    }
+    columns_remove(pokedex, node);
+
+    // NULL if the Pokedex is now empty
+    if (pokedex->selected == node) {
+        if (node->next != NULL) {
+            pokedex->selected = node->next;
+        } else {
+            pokedex->selected = node->prev;
+        }
+    }
+    move_cursors_off(pokedex, node);
+    // No Pokemon is left evolving into the removed one
+    unlink_evolutions(node);
+    destroy_pokenode(pokedex, node);
+}
+
+// Takes every Pokemon out of the Pokedex in Pokedex order, with whether
+// it was found, and returns how many there were. A Pokemon in the
+// Pokedex's arena is cloned instead, since the arena goes with it.
+// Everything else is left for destroy_pokedex.
+static int take_pokemon(Pokedex pokedex, struct taken_pokemon *taken) {
+    int n_taken = 0;
+    struct pokenode *current_node = pokedex->head;
+    while (current_node != NULL) {
+        struct pokenode *next = current_node->next;
+        taken[n_taken].found = is_found(pokedex, current_node);
+        if (pokedex->arena == NULL) {
+            taken[n_taken].pokemon = current_node->pokemon;
+            pokedex->columns.node[current_node->slot] = NULL;
+            free(current_node);
         } else {
-            previous->next = n;
-            n->next = current_node;
+            taken[n_taken].pokemon = clone_pokemon(current_node->pokemon);
+        }
+        n_taken += 1;
+        current_node = next;
+    }
+    if (pokedex->arena == NULL) {
+        pokedex->head = NULL;
+        pokedex->tail = NULL;
+        pokedex->selected = NULL;
+    }
+    return n_taken;
+}
+
+// Orders taken Pokemon by pokemon_id, for qsort
+static int compare_taken_ids(const void *first, const void *second) {
+    int first_id = pokemon_id(((struct taken_pokemon *) first)->pokemon);
+    int second_id = pokemon_id(((struct taken_pokemon *) second)->pokemon);
+    return (first_id > second_id) - (first_id < second_id);
+}
+
+// Sets the pokenode to be found, keeping count of the found Pokemon.
+// Returns 1 if it was not already found, or 0 if it was (perhaps
+// because another thread found it at the same time).
+//
+// The pokenode is added to found_order later, by update_found_order.
+static int mark_found(Pokedex pokedex, struct pokenode *node) {
+    if (!test_and_set_bit(pokedex->columns.found_bits, node->slot)) {
+        return 0;
+    }
+    __atomic_add_fetch(&pokedex->found, 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+// Adds every Pokemon found since found_order was last brought up to
+// date, i.e. those with a found bit but no ordered bit, to found_order
+static void update_found_order(Pokedex pokedex) {
+    struct pokedex_columns *columns = &pokedex->columns;
+    int n_words = (columns->length + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    int word = 0;
+    while (word < n_words) {
+        uint64_t bits = __atomic_load_n(&columns->found_bits[word],
+            __ATOMIC_RELAXED) & ~columns->ordered_bits[word];
+        columns->ordered_bits[word] |= bits;
+        while (bits != 0) {
+            struct pokenode *node =
+                columns->node[word * BITS_PER_WORD + __builtin_ctzll(bits)];
+            id_order_insert(pokedex->found_order, pokemon_id(node->pokemon),
+                node);
+            bits &= bits - 1;
+        }
+        word += 1;
+    }
+}
+
+// Returns 1 if the pokenode's Pokemon has been found, 0 otherwise
+static int is_found(Pokedex pokedex, struct pokenode *node) {
+    return test_bit(pokedex->columns.found_bits, node->slot);
+}
+
+// Scrambles a pokemon_id so that consecutive IDs spread over the table
+static unsigned int hash_id(int id) {
+    unsigned int hash = (unsigned int) id * 2654435769u;
+    return hash ^ (hash >> 16);
+}
+
+// Returns the pokenode with the given pokemon_id, or NULL if there is none
+static struct pokenode *index_lookup(Pokedex pokedex, int id) {
+    if (pokedex->id_capacity == 0) {
+        return NULL;
+    }
+    unsigned int mask = pokedex->id_capacity - 1;
+    unsigned int i = hash_id(id) & mask;
+    // Probes until the ID or an empty slot is reached
+    while (pokedex->id_table[i].node != NULL) {
+        if (pokedex->id_table[i].id == id) {
+            return pokedex->id_table[i].node;
+        }
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+// Adds the pokenode to the index under the ID, returning 1, or returns 0
+// without adding it if the ID is already in the index
+static int index_insert(Pokedex pokedex, int id, struct pokenode *node) {
+    // Keeps the table at most half full so probe sequences stay short
+    if ((pokedex->id_count + 1) * 2 > pokedex->id_capacity) {
+        index_grow(pokedex);
+    }
+    unsigned int mask = pokedex->id_capacity - 1;
+    unsigned int i = hash_id(id) & mask;
+    while (pokedex->id_table[i].node != NULL) {
+        if (pokedex->id_table[i].id == id) {
+            return 0;
         }
+        i = (i + 1) & mask;
     }
+    pokedex->id_table[i].id = id;
+    pokedex->id_table[i].node = node;
+    pokedex->id_count += 1;
+    return 1;
 }
 
-// Changes the character given to a lower case
-static char char_to_lower(char character) {
-    char new_char = character;
-    if (new_char >= 'A' && new_char <= 'Z') { 
-        new_char = new_char - 'A' + 'a';
+// Removes the ID from the index if it is there
+static void index_remove(Pokedex pokedex, int id) {
+    if (pokedex->id_capacity == 0) {
+        return;
+    }
+    unsigned int mask = pokedex->id_capacity - 1;
+    unsigned int i = hash_id(id) & mask;
+    while (pokedex->id_table[i].node != NULL && pokedex->id_table[i].id != id) {
+        i = (i + 1) & mask;
+    }
+    if (pokedex->id_table[i].node == NULL) {
+        return;
+    }
+    pokedex->id_table[i].node = NULL;
+    pokedex->id_count -= 1;
+
+    // Shifts later entries of the probe sequence back into the gap, so
+    // that lookups never stop early at the emptied slot
+    unsigned int gap = i;
+    unsigned int j = (i + 1) & mask;
+    while (pokedex->id_table[j].node != NULL) {
+        unsigned int home = hash_id(pokedex->id_table[j].id) & mask;
+        // Moves the entry if its home slot is not between the gap and j
+        if (((j - home) & mask) >= ((j - gap) & mask)) {
+            pokedex->id_table[gap] = pokedex->id_table[j];
+            pokedex->id_table[j].node = NULL;
+            gap = j;
+        }
+        j = (j + 1) & mask;
     }
-    return new_char;
 }
 
-// Checks whether the text occurs in the name
-static int text_in_name(char *name, char *text) {
+// Doubles the size of the index and reinserts every entry
+static void index_grow(Pokedex pokedex) {
+    struct id_slot *old_table = pokedex->id_table;
+    int old_capacity = pokedex->id_capacity;
+
+    int new_capacity = 16;
+    if (old_capacity != 0) {
+        new_capacity = old_capacity * 2;
+    }
+    pokedex->id_table = calloc(new_capacity, sizeof(struct id_slot));
+    assert(pokedex->id_table != NULL);
+    pokedex->id_capacity = new_capacity;
+    pokedex->id_count = 0;
+
     int i = 0;
-    int is_in_name = 0;
-    int stop = 0;
-    while (name[i] != '\0' && stop == 0) {
-        int j = 0;
-        int still_same = 1;
-        // Sets the name and text characters to be lowercase
-        char name_char = char_to_lower(name[i]);
-        char text_char = char_to_lower(text[j]);
-        // If the first letter of the text matches a letter in the name
-        if (name_char == text_char) {
-            // Loops till the end of text or until they are not the same
-            while (text_char != '\0' && still_same == 1) {
-                if (name_char == text_char) {
-                    is_in_name = 1;
-                } else {
-                    is_in_name = 0;
-                    still_same = 0;
-                }
-                j += 1;
-                // Sets the name and text characters to be the next one in their
-                // respective strings
-                name_char = char_to_lower(name[i+j]);
-                text_char = char_to_lower(text[j]);
-                if (name_char == '\0' && text_char != '\0') {
-                    stop = 1;
-                    still_same = 0;
-                }
-            }
-            // If while loop ended due to reaching the end of text (i.e. the
-            // text is in the name!)
-            if (is_in_name == 1 && stop == 0) {
-                stop = 1;
-            // While loop stopped due to text not being in the name
+    while (i < old_capacity) {
+        if (old_table[i].node != NULL) {
+            index_insert(pokedex, old_table[i].id, old_table[i].node);
+        }
+        i += 1;
+    }
+    free(old_table);
+}
+
+// Starts fetching the index bucket where the ID's search begins
+static void prefetch_index(Pokedex pokedex, int id) {
+    unsigned int bucket = hash_id(id) & (pokedex->id_capacity - 1);
+    __builtin_prefetch(&pokedex->id_table[bucket], 1);
+}
+
+// Gives the pokenode a new slot at the end of the columns
+static void columns_append(Pokedex pokedex, struct pokenode *node) {
+    struct pokedex_columns *columns = &pokedex->columns;
+    if (columns->length == columns->capacity) {
+        columns_grow(columns);
+    }
+
+    int slot = columns->length;
+    columns->node[slot] = node;
+    set_bit(columns->type_bits[pokemon_first_type(node->pokemon)], slot);
+    set_bit(columns->type_bits[pokemon_second_type(node->pokemon)], slot);
+    columns->length += 1;
+    node->slot = slot;
+
+    if (pokedex->name_index != NULL) {
+        name_index_add(pokedex->name_index, slot, pokemon_name(node->pokemon));
+    }
+}
+
+// Turns the pokenode's slot into a hole, compacting the columns once
+// holes make up most of them
+static void columns_remove(Pokedex pokedex, struct pokenode *node) {
+    struct pokedex_columns *columns = &pokedex->columns;
+    int slot = node->slot;
+    columns->node[slot] = NULL;
+    clear_bit(columns->type_bits[pokemon_first_type(node->pokemon)], slot);
+    clear_bit(columns->type_bits[pokemon_second_type(node->pokemon)], slot);
+    clear_bit(columns->found_bits, slot);
+    clear_bit(columns->ordered_bits, slot);
+    columns->holes += 1;
+
+    if (columns->holes > 32 && columns->holes * 2 > columns->length) {
+        columns_compact(pokedex);
+    }
+}
+
+// Moves every Pokemon down into the lowest free slot, removing all holes.
+// Pokemon keep their relative order, so the Pokedex order is unchanged.
+static void columns_compact(Pokedex pokedex) {
+    struct pokedex_columns *columns = &pokedex->columns;
+    int new_slot = 0;
+    // The list is in slot order, and every Pokemon moves to a slot no
+    // later than its current one, so nothing is overwritten before it
+    // has been moved
+    struct pokenode *current_node = pokedex->head;
+    while (current_node != NULL) {
+        int slot = current_node->slot;
+        pokemon_type type1 = pokemon_first_type(current_node->pokemon);
+        pokemon_type type2 = pokemon_second_type(current_node->pokemon);
+        int found = test_bit(columns->found_bits, slot);
+        int ordered = test_bit(columns->ordered_bits, slot);
+
+        // Bits are cleared at the old slot before being set at the new
+        // one, in case they are the same slot
+        clear_bit(columns->type_bits[type1], slot);
+        clear_bit(columns->type_bits[type2], slot);
+        clear_bit(columns->found_bits, slot);
+        clear_bit(columns->ordered_bits, slot);
+
+        columns->node[new_slot] = current_node;
+        set_bit(columns->type_bits[type1], new_slot);
+        set_bit(columns->type_bits[type2], new_slot);
+        if (found) {
+            set_bit(columns->found_bits, new_slot);
+        }
+        if (ordered) {
+            set_bit(columns->ordered_bits, new_slot);
+        }
+
+        current_node->slot = new_slot;
+        new_slot += 1;
+        current_node = current_node->next;
+    }
+    columns->length = new_slot;
+    columns->holes = 0;
+
+    // Every slot has changed, so the name index is rebuilt when it is
+    // next needed
+    if (pokedex->name_index != NULL) {
+        destroy_name_index(pokedex->name_index);
+        pokedex->name_index = NULL;
+    }
+}
+
+// Doubles the number of slots in every column
+static void columns_grow(struct pokedex_columns *columns) {
+    int old_words = columns->capacity / BITS_PER_WORD;
+    int capacity = columns->capacity * 2;
+    if (capacity == 0) {
+        capacity = BITS_PER_WORD;
+    }
+    int words = capacity / BITS_PER_WORD;
+    columns->node = realloc(columns->node, capacity * sizeof(struct pokenode *));
+    assert(columns->node != NULL);
+
+    // New bits start cleared
+    columns->found_bits = realloc(columns->found_bits, words * sizeof(uint64_t));
+    columns->ordered_bits = realloc(columns->ordered_bits,
+        words * sizeof(uint64_t));
+    assert(columns->found_bits != NULL && columns->ordered_bits != NULL);
+    int word = old_words;
+    while (word < words) {
+        columns->found_bits[word] = 0;
+        columns->ordered_bits[word] = 0;
+        word += 1;
+    }
+    int type = 0;
+    while (type < MAX_TYPE) {
+        uint64_t *bits = realloc(columns->type_bits[type], words * sizeof(uint64_t));
+        assert(bits != NULL);
+        word = old_words;
+        while (word < words) {
+            bits[word] = 0;
+            word += 1;
+        }
+        columns->type_bits[type] = bits;
+        type += 1;
+    }
+    columns->capacity = capacity;
+}
+
+// Frees the memory of every column
+static void columns_free(struct pokedex_columns *columns) {
+    free(columns->node);
+    free(columns->found_bits);
+    free(columns->ordered_bits);
+    int type = 0;
+    while (type < MAX_TYPE) {
+        free(columns->type_bits[type]);
+        type += 1;
+    }
+}
+
+// Returns the bit for the slot in the bitset. The word is loaded
+// atomically, since found bits can be set while others read them.
+static int test_bit(uint64_t *bits, int slot) {
+    uint64_t word = __atomic_load_n(&bits[slot / BITS_PER_WORD],
+        __ATOMIC_RELAXED);
+    return (word >> (slot % BITS_PER_WORD)) & 1;
+}
+
+// Sets the bit for the slot in the bitset
+static void set_bit(uint64_t *bits, int slot) {
+    bits[slot / BITS_PER_WORD] |= (uint64_t) 1 << (slot % BITS_PER_WORD);
+}
+
+// Sets the bit for the slot in the bitset without a lock, even while
+// other threads set bits in the same word. Returns 1 if this call set
+// it, or 0 if it was already set.
+static int test_and_set_bit(uint64_t *bits, int slot) {
+    uint64_t bit = (uint64_t) 1 << (slot % BITS_PER_WORD);
+    uint64_t word = __atomic_fetch_or(&bits[slot / BITS_PER_WORD], bit,
+        __ATOMIC_RELAXED);
+    return (word & bit) == 0;
+}
+
+// Clears the bit for the slot in the bitset
+static void clear_bit(uint64_t *bits, int slot) {
+    bits[slot / BITS_PER_WORD] &= ~((uint64_t) 1 << (slot % BITS_PER_WORD));
+}
+
+// Moves every cursor on the pokenode, which is being removed, to the
+// Pokemon after it, or the one before it if it was at the end
+static void move_cursors_off(Pokedex pokedex, struct pokenode *node) {
+    struct pokedex_cursor *cursor = pokedex->cursors;
+    while (cursor != NULL) {
+        if (cursor->node == node) {
+            if (node->next != NULL) {
+                cursor->node = node->next;
             } else {
-                is_in_name = 0;
+                cursor->node = node->prev;
             }
         }
-        i += 1;
+        cursor = cursor->next;
+    }
+}
+
+// Returns the cursor's selected pokenode. A cursor made while the
+// Pokedex was empty (or left by removing every Pokemon) selects the
+// first Pokemon added after that, just like the Pokedex itself.
+static struct pokenode *cursor_node(PokedexCursor cursor) {
+    if (cursor->node == NULL) {
+        cursor->node = cursor->pokedex->head;
+    }
+    return cursor->node;
+}
+
+// Waits until no thread is changing a concurrent Pokedex, then stops
+// any from starting until unlock
+static void read_lock(Pokedex pokedex) {
+    if (pokedex->lock != NULL) {
+        pthread_rwlock_rdlock(pokedex->lock);
+    }
+}
+
+// Waits until no other thread is using a concurrent Pokedex, then stops
+// any from starting until unlock
+static void write_lock(Pokedex pokedex) {
+    if (pokedex->lock != NULL) {
+        pthread_rwlock_wrlock(pokedex->lock);
+    }
+}
+
+// Releases the lock taken by read_lock or write_lock
+static void unlock(Pokedex pokedex) {
+    if (pokedex->lock != NULL) {
+        pthread_rwlock_unlock(pokedex->lock);
+    }
+}
+
+// Returns how many chunks to split a bulk operation on n_items items
+// into, so that each gets at least `grain` of them: 1 if it should run
+// on the calling thread alone
+static int count_chunks(Pokedex pokedex, int n_items, int grain) {
+    int n_threads = 0;
+    if (pokedex->shared_task_pool != NULL) {
+        n_threads = task_pool_threads(pokedex->shared_task_pool);
+    } else {
+        n_threads = pokedex->pool_threads;
+        if (n_threads <= 0) {
+            n_threads = count_processors();
+        }
+    }
+    int n_chunks = n_items / grain;
+    if (n_threads <= 1 || n_chunks < 1) {
+        return 1;
+    } else if (n_chunks > n_threads * CHUNKS_PER_THREAD) {
+        n_chunks = n_threads * CHUNKS_PER_THREAD;
+    }
+    return n_chunks;
+}
+
+// Returns the number of processors, which is only asked of the system
+// once since that can take longer than a small query
+static int count_processors(void) {
+    static int n_processors = 0;
+    int n = __atomic_load_n(&n_processors, __ATOMIC_RELAXED);
+    if (n == 0) {
+        n = sysconf(_SC_NPROCESSORS_ONLN);
+        if (n < 1) {
+            n = 1;
+        }
+        __atomic_store_n(&n_processors, n, __ATOMIC_RELAXED);
+    }
+    return n;
+}
+
+// Returns the first of n_items items in the chunk, or n_items if chunk
+// is n_chunks
+static int chunk_start(int n_items, int n_chunks, int chunk) {
+    return (long) n_items * chunk / n_chunks;
+}
+
+// Calls function(arg, chunk) for every chunk, on the Pokedex's task
+// pool if there is more than one
+static void run_chunks(Pokedex pokedex, int n_chunks, task_function function,
+    void *arg) {
+
+    if (n_chunks == 1) {
+        function(arg, 0);
+    } else {
+        task_pool_run(pokedex_task_pool(pokedex), n_chunks, function, arg);
+    }
+}
+
+// Returns the task pool bulk operations on the Pokedex are split
+// across, making the Pokedex's own if it needs one and has none.
+// Threads holding the lock shared may race to make it, so only the
+// first one made is kept.
+static TaskPool pokedex_task_pool(Pokedex pokedex) {
+    if (pokedex->shared_task_pool != NULL) {
+        return pokedex->shared_task_pool;
+    } else if (pokedex->pool_threads <= 0) {
+        return default_task_pool();
+    }
+    TaskPool pool = __atomic_load_n(&pokedex->own_task_pool, __ATOMIC_ACQUIRE);
+    if (pool == NULL) {
+        TaskPool made = new_task_pool(pokedex->pool_threads);
+        if (__atomic_compare_exchange_n(&pokedex->own_task_pool, &pool, made,
+            0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            pool = made;
+        } else {
+            destroy_task_pool(made);
+        }
     }
-    // Integer representing whether the text is in the name
-    return is_in_name;
+    return pool;
 }
\ No newline at end of file
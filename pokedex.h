@@ -1,19 +1,82 @@
 // Given File
 
 #include "pokemon.h"
+#include "compact_pokemon.h"
+#include "task_pool.h"
 
 #ifndef _POKEDEX_H_
 #define _POKEDEX_H_
 
 typedef struct pokedex *Pokedex;
+typedef struct pokedex_view *PokedexView;
+typedef struct pokedex_cursor *PokedexCursor;
 
 #define DOES_NOT_EVOLVE (-42)
+#define NO_PRE_EVOLUTION (-43)
 
 // Create a new Pokedex and return a pointer to it.
 // The pointer is to a malloced piece of memory, and it is the caller's
 // responsibility to call 'destroy_pokedex' to free that memory.
 Pokedex new_pokedex(void);
 
+// Create a new Pokedex in the same way as new_pokedex, except that its
+// internal memory comes from large contiguous slabs (an arena) owned by
+// the Pokedex rather than one malloc per Pokemon.
+//
+// Pokemon created for this Pokedex with new_pokedex_pokemon also live
+// in the arena. When every Pokemon in the Pokedex came from its arena,
+// destroy_pokedex releases everything at once instead of freeing each
+// Pokemon in turn.
+//
+// This suits Pokedexes that are loaded once and then queried: memory
+// of removed Pokemon is only reused for later Pokemon in the same
+// Pokedex, and is not returned until the Pokedex is destroyed.
+Pokedex new_arena_pokedex(void);
+
+// Create a new Pokedex in the same way as new_pokedex, except that any
+// number of threads can call the functions in this file on it at once.
+//
+// Functions that only look at the Pokedex (e.g. count_total_pokemon,
+// get_pokemon_of_type, search_pokemon, the view_ functions and
+// save_pokedex) run alongside each other without waiting. So do
+// find_current_pokemon, find_pokemon_by_id and go_exploring in
+// EXPLORE_SAMPLED mode, which mark a Pokemon as found by setting a
+// single bit, leaving the ordering of the found Pokemon by pokemon_id
+// to be brought up to date by the next call that needs it. Functions
+// that otherwise change the Pokedex (adding or removing Pokemon,
+// evolutions, moving the currently selected Pokemon and go_exploring
+// in EXPLORE_COMPATIBLE mode) wait for every other call on the Pokedex
+// to finish, and stop new ones from starting until they are done. A
+// normal Pokedex does none of this locking.
+//
+// When several threads find the same Pokemon at once it is found (and
+// counted by count_found_pokemon) only once. A query that runs while
+// Pokemon are being found may or may not include them.
+//
+// Each call sees the Pokedex as it was between two changes. A Pokemon
+// returned by get_current_pokemon (or held by a view) belongs to the
+// Pokedex, and is freed if another thread removes it; threads that
+// keep Pokemon while others remove them should use the copies in the
+// Pokedexes returned by the get_ and search_ functions instead.
+//
+// The Pokedex is destroyed with destroy_pokedex as usual, once no other
+// thread is using it.
+Pokedex new_concurrent_pokedex(void);
+
+// Create a new Pokemon (see new_pokemon in pokemon.h) that is intended
+// to be added to `pokedex`.
+//
+// If the Pokedex was created with new_arena_pokedex, the Pokemon's
+// memory comes from the Pokedex's arena, and the Pokemon must only be
+// added to that Pokedex.
+//
+// Either way, a long name is interned in a name pool belonging to the
+// Pokedex (see new_interned_pokemon in pokemon.h), so that Pokemon with
+// the same name, and the clones of the Pokemon in results like
+// get_pokemon_of_type's, share one copy of it.
+Pokemon new_pokedex_pokemon(Pokedex pokedex, int pokemon_id, char *name,
+    double height, double weight, pokemon_type type1, pokemon_type type2);
+
 ////////////////////////////////////////////////////////////////////////
 //                         Stage 1 Functions                          //
 ////////////////////////////////////////////////////////////////////////
@@ -72,6 +135,16 @@ Pokedex new_pokedex(void);
 // [End of Pokedex]
 void add_pokemon(Pokedex pokedex, Pokemon pokemon);
 
+// Add `n_pokemon` Pokemon to the end of the Pokedex, in the order they
+// are in the array, exactly as calling add_pokemon on each in turn
+// would (including printing an error message and exiting the program
+// if a pokemon_id is already in the Pokedex).
+//
+// Room for every Pokemon is made before any are added, and each
+// Pokemon's pokemon_id is checked and recorded in a single step, so
+// this is faster than calling add_pokemon for large numbers of Pokemon.
+void add_pokemon_bulk(Pokedex pokedex, Pokemon *pokemon, int n_pokemon);
+
 // Print out the details of the currently selected Pokemon in the form:
 //   Id: 007
 //   Name: Squirtle
@@ -113,8 +186,16 @@ Pokemon get_current_pokemon(Pokedex pokedex);
 // (see the assignment spec for more details on what being 'found' means)
 //
 // If there are no Pokemon in the Pokedex, this function does nothing.
+// Finding a Pokemon that has already been found also does nothing.
 void find_current_pokemon(Pokedex pokedex);
 
+// Set the Pokemon with the ID `id` to be 'found', without changing the
+// currently selected Pokemon.
+//
+// Returns 1 if there is a Pokemon with the ID `id` in the Pokedex (even
+// if it was already found), or 0 if there is not.
+int find_pokemon_by_id(Pokedex pokedex, int id);
+
 // Print out all of the Pokemon in the Pokedex, in the order in which
 // they are stored in the Pokedex.
 //
@@ -244,9 +325,19 @@ void change_current_pokemon(Pokedex pokedex, int id);
 // If the removed Pokemon was the only Pokemon in the Pokedex, the
 // currently selected Pokemon should become NULL.
 //
+// Any Pokemon that evolved into the removed Pokemon no longer evolves.
+//
 // If there are no Pokemon in the Pokedex, this function does nothing.
 void remove_pokemon(Pokedex pokedex);
 
+// Remove the Pokemon with the ID `id` from the Pokedex, in the same way
+// as remove_pokemon would if it were the currently selected Pokemon. The
+// currently selected Pokemon only changes if it is the one removed.
+//
+// Returns 1 if there was a Pokemon with the ID `id` in the Pokedex, or
+// 0 (doing nothing) if there was not.
+int remove_pokemon_by_id(Pokedex pokedex, int id);
+
 // Destroy a given Pokedex and free all associated memory.
 void destroy_pokedex(Pokedex pokedex);
 
@@ -279,10 +370,45 @@ void destroy_pokedex(Pokedex pokedex);
 // between 0 and `factor - 1`), this function should print an
 // appropriate error message and exit the program.
 //
-// The random number generator should be seeded with the provided seed
-// `seed` each time this function is called (e.g. `srand(seed)`).
+// Each Pokemon can only be found once, so if there are fewer than
+// `how_many` Pokemon that have not been found with pokemon_id between 0
+// and `factor - 1`, this function should also print an appropriate
+// error message and exit the program.
+//
+// The random number generator is seeded with the provided seed `seed`
+// each time this function is called (i.e. `srand(seed)`), and each
+// pokemon_id is drawn with `rand() % factor`, unless the Pokedex has
+// been put in EXPLORE_SAMPLED mode (see set_exploring_mode). Either way,
+// the same seed on the same Pokedex always finds the same Pokemon.
+//
+// On a Pokedex made by new_concurrent_pokedex, other threads exploring
+// in EXPLORE_SAMPLED mode at the same time may find some of the chosen
+// Pokemon first. Others are chosen in their place, and if none are
+// left this function finds fewer than `how_many` Pokemon.
 void go_exploring(Pokedex pokedex, int seed, int factor, int how_many);
 
+// The ways go_exploring can choose which Pokemon are encountered.
+typedef enum exploring_mode {
+    // Chooses `how_many` of the Pokemon that could be found, each with
+    // equal chance, in time proportional to the size of the Pokedex.
+    // `seed` seeds a generator belonging to the call, so the C library's
+    // rand() is not used, but the Pokemon found for a seed differ from
+    // those found in EXPLORE_COMPATIBLE mode.
+    EXPLORE_SAMPLED,
+
+    // Seeds the C library's generator with `srand(seed)` and draws
+    // pokemon_ids with `rand() % factor` until `how_many` new Pokemon
+    // have been found, which finds the same Pokemon for a seed as
+    // go_exploring always has. Many draws may be needed when few of the
+    // pokemon_ids in range belong to Pokemon that are not yet found.
+    // This is the mode of a new Pokedex.
+    EXPLORE_COMPATIBLE
+} exploring_mode;
+
+// Set how go_exploring chooses Pokemon in this Pokedex.
+// A new Pokedex is in EXPLORE_COMPATIBLE mode.
+void set_exploring_mode(Pokedex pokedex, exploring_mode mode);
+
 // Return the number of Pokemon in the Pokedex that have been found.
 int count_found_pokemon(Pokedex pokedex);
 
@@ -314,17 +440,27 @@ int count_total_pokemon(Pokedex pokedex);
 // The end result of the these three function calls would be that
 // Pokemon 0 evolves into Pokemon 3 (rather than 1 or 2).
 //
+// Any number of Pokemon can evolve into the same Pokemon.
+//
 // If there is no Pokemon with the ID `from_id` or `to_id`,
 // or if the provided `from_id` and `to_id` are the same,
 // this function should print an appropriate error message and exit the
-// program.
+// program. It does the same if the Pokemon with `to_id` already
+// evolves (directly or through other Pokemon) into the Pokemon with
+// `from_id`, since no Pokemon can evolve into itself.
 void add_pokemon_evolution(Pokedex pokedex, int from_id, int to_id);
 
 // Show the evolutions of the currently selected Pokemon.
 // It should include the Pokemon it evolves into (if any), as well as
 // any evolutions that its evolved state can evolve into, and so on.
 //
-// For example:
+// The chain starts from the Pokemon the currently selected Pokemon
+// evolved from, if any, and the one that evolved into that, and so on
+// (following get_prev_evolution). The start of each Pokemon's chain is
+// kept up to date as evolutions are added and removed, so showing it
+// never searches the Pokedex.
+//
+// For example, with Charmeleon or any of these Pokemon selected:
 //
 // #004 Charmander [Fire] --> #005 Charmeleon [Fire] --> #006 Charizard [Fire, Flying]
 //
@@ -347,6 +483,18 @@ void show_evolutions(Pokedex pokedex);
 // error message and exit the program.
 int get_next_evolution(Pokedex pokedex);
 
+// Return the pokemon_id of the Pokemon that evolves into the currently
+// selected Pokemon, or of the first of them in Pokedex order if there
+// are several. Every Pokemon keeps a list of the Pokemon that evolve
+// into it, so this takes constant time.
+//
+// If no Pokemon evolves into the currently selected Pokemon, this
+// function should return NO_PRE_EVOLUTION.
+//
+// If the Pokedex is empty, this function should print an appropriate
+// error message and exit the program.
+int get_prev_evolution(Pokedex pokedex);
+
 ////////////////////////////////////////////////////////////////////////
 //                         Stage 5 Functions                          //
 ////////////////////////////////////////////////////////////////////////
@@ -400,6 +548,24 @@ int get_next_evolution(Pokedex pokedex);
 // those copies into the new Pokedex.
 Pokedex get_pokemon_of_type(Pokedex pokedex, pokemon_type type);
 
+// Create a new Pokedex which contains only the found Pokemon that have
+// both of the specified types (e.g. FIRE_TYPE and FLYING_TYPE), in the
+// same way as get_pokemon_of_type.
+//
+// If either type is NONE_TYPE, INVALID_TYPE, or MAX_TYPE, this function
+// should print an appropriate error message and exit the program.
+Pokedex get_pokemon_of_both_types(Pokedex pokedex, pokemon_type first,
+    pokemon_type second);
+
+// Create a new Pokedex which contains only the found Pokemon that have
+// either of the specified types (e.g. WATER_TYPE or ICE_TYPE), in the
+// same way as get_pokemon_of_type.
+//
+// If either type is NONE_TYPE, INVALID_TYPE, or MAX_TYPE, this function
+// should print an appropriate error message and exit the program.
+Pokedex get_pokemon_of_either_type(Pokedex pokedex, pokemon_type first,
+    pokemon_type second);
+
 // Create a new Pokedex which contains only the Pokemon that have
 // previously been 'found' from the original Pokedex.
 //
@@ -494,4 +660,261 @@ Pokedex get_found_pokemon(Pokedex pokedex);
 // !! You must not call any functions from string.h in this function !!
 Pokedex search_pokemon(Pokedex pokedex, char *text);
 
+// Make a new Pokedex holding every Pokemon of the Pokedexes in
+// `pokedexes`, in order of pokemon_id, with the same ones found, and
+// destroy those Pokedexes. The currently selected Pokemon is the first.
+//
+// The Pokemon are moved to the new Pokedex rather than copied (unless
+// they are in an arena Pokedex's arena), so this is how the results of
+// several get_ or search_ calls are combined. No other thread can be
+// using the Pokedexes, and no pokemon_id can be in more than one of
+// them, or this function prints an error message and exits.
+Pokedex merge_pokedexes(Pokedex *pokedexes, int n_pokedexes);
+
+////////////////////////////////////////////////////////////////////////
+//                         Snapshots                                  //
+////////////////////////////////////////////////////////////////////////
+
+// Write the Pokedex to the file at `path`, replacing anything already
+// there, so that it can be loaded again with load_pokedex.
+//
+// The file holds every Pokemon in Pokedex order with whether it has
+// been found, every evolution, and the currently selected Pokemon. It
+// is a versioned binary format with a checksum, made of fixed-width
+// records followed by one pool of names, in the byte order of the
+// machine that wrote it.
+//
+// The snapshot is first written to `path` with ".tmp" added, which is
+// then renamed to `path`, so a failed write leaves any file already at
+// `path` as it was.
+//
+// Returns 1 if the file was written, or 0 if it could not be.
+int save_pokedex(Pokedex pokedex, char *path);
+
+// Create a new Pokedex from a file written by save_pokedex, with the
+// same Pokemon in the same order, the same found Pokemon, evolutions
+// and currently selected Pokemon.
+//
+// The file is mapped into memory and checked in place, then the
+// Pokedex is built in a single pass. It is an arena Pokedex (see
+// new_arena_pokedex) whose index and columns have room for every
+// Pokemon reserved up front, so they never grow while loading. Each
+// Pokemon still comes from the arena, and a long name is interned in
+// the Pokedex's name pool.
+//
+// Returns NULL if the file cannot be read, or is not a complete
+// snapshot of this version with a matching checksum.
+Pokedex load_pokedex(char *path);
+
+////////////////////////////////////////////////////////////////////////
+//                         Compact Records                            //
+////////////////////////////////////////////////////////////////////////
+
+// Pack every Pokemon in the Pokedex into one array of compact records
+// (see CompactPokemon in compact_pokemon.h), in Pokedex order.
+//
+// Returns the number of Pokemon, and sets `*records` to a malloced
+// array of them which the caller must free. Whether Pokemon are found,
+// evolutions and the currently selected Pokemon are not kept.
+//
+// Returns -1 (and sets `*records` to NULL) if any Pokemon cannot be
+// packed without losing something (see pack_pokemon).
+int pack_pokedex(Pokedex pokedex, CompactPokemon **records);
+
+// Create a new Pokedex holding a Pokemon for each of the `n_records`
+// records, in order, with exactly the attributes of the Pokemon that
+// were packed. None of them are found and none evolve.
+//
+// The Pokedex is an arena Pokedex (see new_arena_pokedex) and the
+// Pokemon are added with add_pokemon_bulk.
+Pokedex unpack_pokedex(CompactPokemon *records, int n_records);
+
+////////////////////////////////////////////////////////////////////////
+//                         Pokedex Views                              //
+////////////////////////////////////////////////////////////////////////
+
+// A PokedexView holds the result of a Stage 5 query without copying
+// any Pokemon: it refers to the Pokemon in the original Pokedex, in the
+// order the matching get_ or search_ function would have added them.
+//
+// A view has its own currently selected Pokemon, which starts out as
+// the first Pokemon in the view. The original Pokedex's currently
+// selected Pokemon is never changed by a view.
+//
+// A view is only valid until Pokemon are next added to or removed from
+// the original Pokedex, or it is destroyed. Finding Pokemon does not
+// invalidate a view, but does not add them to it either.
+//
+// It is the caller's responsibility to call 'destroy_view' to free the
+// view's memory.
+
+// Create a view of the found Pokemon of the given type, in the same way
+// as get_pokemon_of_type (including exiting on an invalid type).
+PokedexView view_pokemon_of_type(Pokedex pokedex, pokemon_type type);
+
+// Create a view of the found Pokemon with both of the given types, in
+// the same way as get_pokemon_of_both_types.
+PokedexView view_pokemon_of_both_types(Pokedex pokedex, pokemon_type first,
+    pokemon_type second);
+
+// Create a view of the found Pokemon with either of the given types, in
+// the same way as get_pokemon_of_either_type.
+PokedexView view_pokemon_of_either_type(Pokedex pokedex, pokemon_type first,
+    pokemon_type second);
+
+// Create a view of the found Pokemon in ascending order of pokemon_id,
+// in the same way as get_found_pokemon.
+PokedexView view_found_pokemon(Pokedex pokedex);
+
+// Create a view of the found Pokemon with pokemon_id from `min_id` to
+// `max_id` (inclusive), in ascending order of pokemon_id.
+//
+// The Pokedex keeps its found Pokemon ordered by pokemon_id, so this
+// takes time proportional to the number of Pokemon in the view, plus
+// the logarithm of the number of found Pokemon.
+//
+// If min_id is greater than max_id, the view is empty.
+PokedexView view_found_pokemon_in_range(Pokedex pokedex, int min_id,
+    int max_id);
+
+// Create a view of the found Pokemon with the given text in their name,
+// in the same way as search_pokemon.
+PokedexView view_search_pokemon(Pokedex pokedex, char *text);
+
+// Return the number of Pokemon in the view.
+int view_count(PokedexView view);
+
+// Return the view's currently selected Pokemon (the Pokemon in the
+// original Pokedex, not a copy).
+//
+// If the view is empty, this function should print an appropriate
+// error message and exit the program.
+Pokemon view_current_pokemon(PokedexView view);
+
+// Move the view's currently selected Pokemon to the next Pokemon in the
+// view, staying put at the end of the view (like next_pokemon).
+void view_next_pokemon(PokedexView view);
+
+// Move the view's currently selected Pokemon to the previous Pokemon in
+// the view, staying put at the start of the view (like prev_pokemon).
+void view_prev_pokemon(PokedexView view);
+
+// Print out all of the Pokemon in the view in the same form as
+// print_pokemon, with an arrow next to the view's currently selected
+// Pokemon. Every Pokemon in a view has been found, so every name is
+// shown.
+void print_view(PokedexView view);
+
+// Create a new Pokedex holding copies of the Pokemon in the view, set
+// to be found and without evolutions, exactly as the get_ or search_
+// function the view came from would have returned.
+//
+// The view is unchanged, and must still be destroyed.
+Pokedex materialize_view(PokedexView view);
+
+// Free all of the memory used by the view. The Pokemon it refers to are
+// not freed.
+void destroy_view(PokedexView view);
+
+////////////////////////////////////////////////////////////////////////
+//                         Pokedex Cursors                            //
+////////////////////////////////////////////////////////////////////////
+
+// A PokedexCursor is a currently selected Pokemon of its own, for one
+// user (or session) browsing a Pokedex that others are browsing too.
+// Moving a cursor never changes the Pokedex's currently selected
+// Pokemon or any other cursor, and a cursor holds no copy of the
+// Pokedex, only a few pointers.
+//
+// A cursor stays valid while Pokemon are added to and removed from the
+// Pokedex. If the Pokemon a cursor selects is removed, the cursor moves
+// to the next Pokemon the same way the Pokedex's currently selected
+// Pokemon would (see remove_pokemon), so removing a Pokemon takes time
+// proportional to the number of cursors of the Pokedex.
+//
+// On a Pokedex made by new_concurrent_pokedex, each cursor may be used
+// by one thread at a time while other threads use the Pokedex and their
+// own cursors.
+//
+// It is the caller's responsibility to call 'destroy_pokedex_cursor' to
+// free the cursor's memory, before the Pokedex is destroyed.
+
+// Create a cursor selecting the first Pokemon in the Pokedex. If the
+// Pokedex is empty, the cursor selects the first Pokemon added to it.
+PokedexCursor new_pokedex_cursor(Pokedex pokedex);
+
+// Return the Pokemon selected by the cursor (the Pokemon in the
+// Pokedex, not a copy), in the same way as get_current_pokemon.
+//
+// If the Pokedex is empty, this function should print an appropriate
+// error message and exit the program.
+Pokemon cursor_current_pokemon(PokedexCursor cursor);
+
+// Move the cursor to the next Pokemon in the Pokedex, staying put at
+// the end of the Pokedex (like next_pokemon).
+void cursor_next_pokemon(PokedexCursor cursor);
+
+// Move the cursor to the previous Pokemon in the Pokedex, staying put
+// at the start of the Pokedex (like prev_pokemon).
+void cursor_prev_pokemon(PokedexCursor cursor);
+
+// Move the cursor to the Pokemon with the given pokemon_id, staying put
+// if there is none (like change_current_pokemon).
+void cursor_change_pokemon(PokedexCursor cursor, int id);
+
+// Print out the details of the Pokemon selected by the cursor, in the
+// same way as detail_pokemon.
+void cursor_detail_pokemon(PokedexCursor cursor);
+
+// Set the Pokemon selected by the cursor to be 'found', in the same way
+// as find_current_pokemon.
+void cursor_find_pokemon(PokedexCursor cursor);
+
+// Print out the evolution chain of the Pokemon selected by the cursor,
+// in the same way as show_evolutions.
+void cursor_show_evolutions(PokedexCursor cursor);
+
+// Return the pokemon_id of the next evolution of the Pokemon selected
+// by the cursor, in the same way as get_next_evolution.
+int cursor_next_evolution(PokedexCursor cursor);
+
+// Return the pokemon_id of the Pokemon that evolves into the Pokemon
+// selected by the cursor, in the same way as get_prev_evolution.
+int cursor_prev_evolution(PokedexCursor cursor);
+
+// Free all of the memory used by the cursor. The Pokedex and its
+// Pokemon are not changed.
+void destroy_pokedex_cursor(PokedexCursor cursor);
+
+////////////////////////////////////////////////////////////////////////
+//                         Task Pools                                 //
+////////////////////////////////////////////////////////////////////////
+
+// Bulk operations on a large Pokedex are split into chunks and run on a
+// TaskPool (see task_pool.h): the Stage 5 get_ and search_ functions
+// and their views, go_exploring in EXPLORE_SAMPLED mode, and
+// destroy_pokedex. Each chunk is a run of Pokemon in Pokedex order, and
+// the chunks' results are joined in that same order, so no result
+// depends on the number of threads. get_found_pokemon only walks the
+// found Pokemon in order of pokemon_id, and is never split.
+//
+// An operation with too few Pokemon for the threads to pay off runs on
+// the calling thread alone. By default every Pokedex uses the one pool
+// shared by the whole process (see default_task_pool), so having many
+// Pokedexes does not mean having more threads.
+
+// Give the Pokedex a task pool of its own with `n_threads` threads, or
+// go back to default_task_pool if `n_threads` is 0 (the default). The
+// Pokedex's own pool is made the first time an operation is split, and
+// destroyed with the Pokedex. With one thread, every operation runs on
+// the calling thread.
+void set_pool_threads(Pokedex pokedex, int n_threads);
+
+// Make bulk operations on the Pokedex use `pool` instead of the one
+// set_pool_threads chose, or go back to that one if `pool` is NULL.
+//
+// The pool is not destroyed with the Pokedex, and must not be destroyed
+// while the Pokedex uses it.
+void set_task_pool(Pokedex pokedex, TaskPool pool);
+
 #endif //  _POKEDEX_H_
\ No newline at end of file
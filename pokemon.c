@@ -5,6 +5,9 @@
 #include <string.h>
 #include <assert.h>
 
+// Makes pokemon.h define struct pokemon, but not replace the accessors
+// defined below with unchecked ones.
+#define POKEMON_IMPLEMENTATION
 #include "pokemon.h"
 
 const static char *types[] = {
@@ -31,16 +34,47 @@ const static char *types[] = {
 
 #define POKEMON_MAGIC_NUMBER 0xDEADBEEF
 
+// Type names are 3 to 8 letters long, and no two have the same length
+// and first two letters hashed together this way (the table below
+// would have an overridden initializer if they did), so a name can
+// only be the type in its slot of type_hash_table.
+#define MIN_TYPE_NAME_LENGTH 3
+#define MAX_TYPE_NAME_LENGTH 8
+#define TYPE_HASH_SIZE 32
+#define TYPE_HASH(length, first, second) \
+    (((length) * 3 + ((first) | 0x20) * 11 + ((second) | 0x20) * 7) \
+        & (TYPE_HASH_SIZE - 1))
+
+static const pokemon_type type_hash_table[TYPE_HASH_SIZE] = {
+    [TYPE_HASH(4, 'n', 'o')] = NONE_TYPE,
+    [TYPE_HASH(6, 'n', 'o')] = NORMAL_TYPE,
+    [TYPE_HASH(4, 'f', 'i')] = FIRE_TYPE,
+    [TYPE_HASH(8, 'f', 'i')] = FIGHTING_TYPE,
+    [TYPE_HASH(5, 'w', 'a')] = WATER_TYPE,
+    [TYPE_HASH(6, 'f', 'l')] = FLYING_TYPE,
+    [TYPE_HASH(5, 'g', 'r')] = GRASS_TYPE,
+    [TYPE_HASH(6, 'p', 'o')] = POISON_TYPE,
+    [TYPE_HASH(8, 'e', 'l')] = ELECTRIC_TYPE,
+    [TYPE_HASH(6, 'g', 'r')] = GROUND_TYPE,
+    [TYPE_HASH(7, 'p', 's')] = PSYCHIC_TYPE,
+    [TYPE_HASH(4, 'r', 'o')] = ROCK_TYPE,
+    [TYPE_HASH(3, 'i', 'c')] = ICE_TYPE,
+    [TYPE_HASH(3, 'b', 'u')] = BUG_TYPE,
+    [TYPE_HASH(6, 'd', 'r')] = DRAGON_TYPE,
+    [TYPE_HASH(5, 'g', 'h')] = GHOST_TYPE,
+    [TYPE_HASH(4, 'd', 'a')] = DARK_TYPE,
+    [TYPE_HASH(5, 's', 't')] = STEEL_TYPE,
+    [TYPE_HASH(5, 'f', 'a')] = FAIRY_TYPE,
+};
+
 
 ////////////////////////////////////////////////////////////////////////
 //                           struct pokemon                           //
 ////////////////////////////////////////////////////////////////////////
 
-// This is the struct that stores all of the internal information about
-// a Pokemon.
-//
-// Because this struct is in pokemon.c (not pokemon.h), you cannot
-// access it directly from pokedex.c
+// The structs that store all of the internal information about a
+// Pokemon are defined in pokemon.h, but only for this file and for the
+// unchecked accessors of release builds.
 //
 // _This is intentional_, because you should only interact with Pokemon
 // via the functions in pokemon.h, rather than trying to access the
@@ -50,23 +84,28 @@ const static char *types[] = {
 //    error: incomplete definition of type 'struct pokemon'
 // you must make sure that you are only interacting with Pokemon via the
 // functions in pokemon.h (e.g. pokemon_id, pokemon_name, etc).
-struct pokemon {
-    int          magic_number;
-    int          pokemon_id;
-    char         *name;
-    double       height;
-    double       weight;
-    pokemon_type type1;
-    pokemon_type type2;
+
+// A Pokemon that is not a clone, allocated together with its body
+struct owned_pokemon {
+    struct pokemon      pokemon;
+    struct pokemon_body body;
 };
 
 // Helper functions. These can only be called from pokemon.c (this file),
 // not pokedex.c or test_pokedex.c.
 static int valid_character(int c);
 static int valid_pokemon_type(pokemon_type type);
+static void check_new_pokemon(int pokemon_id, pokemon_type type1,
+    pokemon_type type2, char *function_name);
 static void check_valid_pokemon(Pokemon pokemon, char *function_name);
 static void die(char *function_name, char *message);
 static char *check_address_is_heap_pointer(void *p, size_t size);
+static Pokemon new_owned_pokemon(Arena arena, NamePool pool, int pokemon_id,
+    char *name, double height, double weight, pokemon_type type1,
+    pokemon_type type2);
+static void set_body_name(struct pokemon_body *body, char *name, Arena arena,
+    NamePool pool);
+static void release_body(struct pokemon_body *body);
 
 ////////////////////////////////////////////////////////////////////////
 //      See pokemon.h for details about all of the functions below.   //
@@ -79,97 +118,117 @@ static char *check_address_is_heap_pointer(void *p, size_t size);
 Pokemon new_pokemon(int pokemon_id, char *name, double height,
     double weight, pokemon_type type1, pokemon_type type2) {
 
-    if (pokemon_id < 0) {
-        die("new_pokemon", "invalid pokemon_id");
-    }
-
-    if (!valid_pokemon_type(type1)) {
-        die("new_pokemon", "type1 is invalid");
-    }
-
-    if (!valid_pokemon_type(type2)) {
-        die("new_pokemon", "type2 is invalid");
-    }
-
-    if (type1 == NONE_TYPE) {
-        die("new_pokemon", "type1 is NONE_TYPE");
-    }
-
-    if (type1 == type2) {
-        die("new_pokemon", "type1 and type2 must be different");
-    }
+    check_new_pokemon(pokemon_id, type1, type2, "new_pokemon");
+    return new_owned_pokemon(NULL, NULL, pokemon_id, name, height, weight,
+        type1, type2);
+}
 
-    Pokemon new_pokemon = malloc(sizeof(struct pokemon));
-    assert(new_pokemon != NULL);
+// Create a new Pokemon whose memory comes from `arena`.
+//
+// See the comments above new_arena_pokemon in pokemon.h for the full
+// details.
+Pokemon new_arena_pokemon(Arena arena, int pokemon_id, char *name,
+    double height, double weight, pokemon_type type1, pokemon_type type2) {
+
+    check_new_pokemon(pokemon_id, type1, type2, "new_arena_pokemon");
+    return new_owned_pokemon(arena, NULL, pokemon_id, name, height, weight,
+        type1, type2);
+}
 
-    new_pokemon->magic_number = POKEMON_MAGIC_NUMBER;
-    new_pokemon->pokemon_id = pokemon_id;
-    new_pokemon->name = strdup(name);
-    assert(name != NULL);
-    new_pokemon->height = height;
-    new_pokemon->weight = weight;
-    new_pokemon->type1 = type1;
-    new_pokemon->type2 = type2;
-    return new_pokemon;
+// Create a new Pokemon whose long name is interned in `pool`.
+//
+// See the comments above new_interned_pokemon in pokemon.h for the full
+// details.
+Pokemon new_interned_pokemon(Arena arena, NamePool pool, int pokemon_id,
+    char *name, double height, double weight, pokemon_type type1,
+    pokemon_type type2) {
+
+    check_new_pokemon(pokemon_id, type1, type2, "new_interned_pokemon");
+    return new_owned_pokemon(arena, pool, pokemon_id, name, height, weight,
+        type1, type2);
 }
 
 // Return the pokemon_id of the specified `pokemon`.
 int pokemon_id(Pokemon pokemon) {
     check_valid_pokemon(pokemon, "pokemon_id");
-    return pokemon->pokemon_id;
+    return pokemon->body->pokemon_id;
 }
 
 // Return the pokemon_name of the specified `pokemon`.
 char *pokemon_name(Pokemon pokemon) {
     check_valid_pokemon(pokemon, "pokemon_name");
-    return pokemon->name;
+    return pokemon->body->name;
 }
 
 // Return the pokemon_height of the specified `pokemon`.
 double pokemon_height(Pokemon pokemon) {
     check_valid_pokemon(pokemon, "pokemon_height");
-    return pokemon->height;
+    return pokemon->body->height;
 }
 
 // Return the pokemon_weight of the specified `pokemon`.
 double pokemon_weight(Pokemon pokemon) {
     check_valid_pokemon(pokemon, "pokemon_weight");
-    return pokemon->weight;
+    return pokemon->body->weight;
 }
 
 // Return the first type of the specified `pokemon`.
 pokemon_type pokemon_first_type(Pokemon pokemon) {
     check_valid_pokemon(pokemon, "pokemon_first_type");
-    return pokemon->type1;
+    return pokemon->body->type1;
 }
 
 // Return the second type of the specified `pokemon`.
 pokemon_type pokemon_second_type(Pokemon pokemon) {
     check_valid_pokemon(pokemon, "pokemon_second_type");
-    return pokemon->type2;
+    return pokemon->body->type2;
 }
 
-// Return a clone of the specified `pokemon`.
+// Return the arena the specified `pokemon` was allocated from.
+Arena pokemon_arena(Pokemon pokemon) {
+    check_valid_pokemon(pokemon, "pokemon_arena");
+    return pokemon->arena;
+}
+
+// Return a clone of the specified `pokemon`, sharing its body unless
+// the body is in an arena.
 Pokemon clone_pokemon(Pokemon pokemon) {
     check_valid_pokemon(pokemon, "clone_pokemon");
-    return new_pokemon(
-        pokemon->pokemon_id,
-        pokemon->name,
-        pokemon->height,
-        pokemon->weight,
-        pokemon->type1,
-        pokemon->type2
-    );
+
+    struct pokemon_body *body = pokemon->body;
+    if (pokemon->arena != NULL) {
+        return new_owned_pokemon(NULL, body->name_pool, body->pokemon_id,
+            body->name, body->height, body->weight, body->type1, body->type2);
+    }
+
+    Pokemon clone = malloc(sizeof(struct pokemon));
+    assert(clone != NULL);
+    clone->magic_number = POKEMON_MAGIC_NUMBER;
+    clone->body = body;
+    clone->arena = NULL;
+    __atomic_add_fetch(&body->references, 1, __ATOMIC_RELAXED);
+    return clone;
 }
 
 // Destroy the specified `pokemon`.
+//
+// Its body (and the memory of the Pokemon that holds the body) is only
+// freed once every Pokemon sharing it has been destroyed.
 void destroy_pokemon(Pokemon pokemon) {
     check_valid_pokemon(pokemon, "destroy_pokemon");
-    free(pokemon->name);
-    free(pokemon);
+    // The Pokemon must no longer be used, even while its memory is kept
+    pokemon->magic_number = 0;
+    if (pokemon->arena != NULL) {
+        // The memory is released with the arena
+        return;
+    }
+    struct pokemon_body *body = pokemon->body;
+    if (body->owner != pokemon) {
+        free(pokemon);
+    }
+    release_body(body);
 }
 
-
 // Check whether `name` is a valid name for a Pokemon.
 // Valid names consist of letters, spaces, and dashes.
 // See the `valid_character` function below for more details.
@@ -200,16 +259,34 @@ static int valid_character(int c) {
 // Determine the pokemon_type associated with the given string.
 // For example: "Fire" or "fire" would return FIRE_TYPE.
 //
+// The string's length and first two letters pick the only type it
+// could be from type_hash_table, which is then compared with the
+// string. Every letter of a type name is lowercase once 0x20 is set,
+// so two characters are the same letter (ignoring case) exactly when
+// they match with 0x20 set.
+//
 // If there is no matching pokemon_type, the function returns
 // INVALID_TYPE.
 pokemon_type pokemon_type_from_string(char *str) {
-    for (int i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
-        if (strcasecmp(types[i], str) == 0) {
-            return (pokemon_type) i;
-        }
+    int length = 0;
+    while (length <= MAX_TYPE_NAME_LENGTH && str[length] != '\0') {
+        length++;
+    }
+    if (length < MIN_TYPE_NAME_LENGTH || length > MAX_TYPE_NAME_LENGTH) {
+        return INVALID_TYPE;
+    }
 
+    pokemon_type type = type_hash_table[TYPE_HASH(length, str[0], str[1])];
+    const char *name = types[type];
+    for (int i = 0; i < length; i++) {
+        if ((str[i] | 0x20) != (name[i] | 0x20)) {
+            return INVALID_TYPE;
+        }
+    }
+    if (name[length] != '\0') {
+        return INVALID_TYPE;
     }
-    return INVALID_TYPE;
+    return type;
 }
 
 // Convert a pokemon_type into its corresponding string.
@@ -219,6 +296,32 @@ const char *pokemon_type_to_string(pokemon_type type) {
     return types[type];
 }
 
+// Check the attributes given for a new Pokemon, printing an error
+// message and exiting the program if any are invalid.
+static void check_new_pokemon(int pokemon_id, pokemon_type type1,
+    pokemon_type type2, char *function_name) {
+
+    if (pokemon_id < 0) {
+        die(function_name, "invalid pokemon_id");
+    }
+
+    if (!valid_pokemon_type(type1)) {
+        die(function_name, "type1 is invalid");
+    }
+
+    if (!valid_pokemon_type(type2)) {
+        die(function_name, "type2 is invalid");
+    }
+
+    if (type1 == NONE_TYPE) {
+        die(function_name, "type1 is NONE_TYPE");
+    }
+
+    if (type1 == type2) {
+        die(function_name, "type1 and type2 must be different");
+    }
+}
+
 // Check whether `type` is a valid pokemon_type.
 static int valid_pokemon_type(pokemon_type type) {
     return type > INVALID_TYPE && type < MAX_TYPE;
@@ -253,6 +356,82 @@ static void check_valid_pokemon(Pokemon pokemon, char *function_name) {
     }
 }
 
+// Create a new Pokemon with a body of its own, from `arena` if it is not
+// NULL and malloced otherwise, with a long name interned in `pool` if it
+// is not NULL.
+static Pokemon new_owned_pokemon(Arena arena, NamePool pool, int pokemon_id,
+    char *name, double height, double weight, pokemon_type type1,
+    pokemon_type type2) {
+
+    struct owned_pokemon *owned = NULL;
+    if (arena == NULL) {
+        owned = malloc(sizeof(struct owned_pokemon));
+        assert(owned != NULL);
+    } else {
+        owned = arena_alloc(arena, sizeof(struct owned_pokemon));
+    }
+
+    Pokemon new_pokemon = &owned->pokemon;
+    new_pokemon->magic_number = POKEMON_MAGIC_NUMBER;
+    new_pokemon->body = &owned->body;
+    new_pokemon->arena = arena;
+
+    struct pokemon_body *body = &owned->body;
+    body->references = 1;
+    body->pokemon_id = pokemon_id;
+    set_body_name(body, name, arena, pool);
+    body->height = height;
+    body->weight = weight;
+    body->type1 = type1;
+    body->type2 = type2;
+    body->owner = NULL;
+    if (arena == NULL) {
+        body->owner = new_pokemon;
+    }
+    return new_pokemon;
+}
+
+// Set the name of a new body: in the body itself if it is short enough,
+// otherwise interned in `pool` if there is one, or else copied into
+// `arena` if there is one, or else malloced.
+//
+// A malloced body takes a reference to the pool its name is in.
+static void set_body_name(struct pokemon_body *body, char *name, Arena arena,
+    NamePool pool) {
+
+    size_t length = strlen(name);
+    body->name_pool = NULL;
+    if (length < SHORT_NAME_SIZE) {
+        memcpy(body->short_name, name, length + 1);
+        body->name = body->short_name;
+    } else if (pool != NULL) {
+        body->name = name_pool_intern(pool, name);
+        body->name_pool = pool;
+        if (arena == NULL) {
+            name_pool_retain(pool);
+        }
+    } else if (arena != NULL) {
+        body->name = arena_strdup(arena, name);
+    } else {
+        body->name = strdup(name);
+        assert(body->name != NULL);
+    }
+}
+
+// Remove a reference to a malloced body, freeing its name and the
+// Pokemon holding it once no Pokemon share it.
+static void release_body(struct pokemon_body *body) {
+    if (__atomic_sub_fetch(&body->references, 1, __ATOMIC_ACQ_REL) > 0) {
+        return;
+    }
+    if (body->name_pool != NULL) {
+        name_pool_release(body->name_pool);
+    } else if (body->name != body->short_name) {
+        free(body->name);
+    }
+    free(body->owner);
+}
+
 static void die(char *function_name, char *message) {
     fprintf(stderr, "%s: %s\n", function_name, message);
     exit(1);
@@ -3,6 +3,9 @@
 #ifndef _POKEMON_H_
 #define _POKEMON_H_
 
+#include "arena.h"
+#include "name_pool.h"
+
 ////////////////////////////////////////////////////////////////////////
 //                     enum pokemon_type                              //
 ////////////////////////////////////////////////////////////////////////
@@ -53,11 +56,11 @@ typedef enum pokemon_type {
 // This typedef declares that the type "Pokemon" is the same as the type
 // "pointer to struct pokemon".
 //
-// The actual definition of `struct pokemon` is not in pokemon.h (this
-// file) -- it's in pokemon.c
-//
-// This means that you cannot directly access any of the fields of the
-// pokemon struct -- e.g. "pokemon->pokemon_id" is *invalid*.
+// The definition of `struct pokemon` is only visible in unchecked
+// builds and in pokemon.c (see "Unchecked Pokemon accessors" below),
+// so that the inline accessors there can read it. Even then, you should
+// not access its fields directly -- e.g. use pokemon_id(pokemon) rather
+// than "pokemon->body->pokemon_id".
 //
 // If you get the following error:
 //
@@ -99,6 +102,31 @@ typedef struct pokemon *Pokemon;
 Pokemon new_pokemon(int pokemon_id, char *name, double height,
     double weight, pokemon_type type1, pokemon_type type2);
 
+// Create a new Pokemon in the same way as new_pokemon, except that the
+// memory for the Pokemon (including its name) comes from `arena`.
+//
+// The Pokemon can still be passed to destroy_pokemon, after which it
+// must not be used, but its memory is only released when the arena is
+// destroyed.
+Pokemon new_arena_pokemon(Arena arena, int pokemon_id, char *name,
+    double height, double weight, pokemon_type type1, pokemon_type type2);
+
+// Create a new Pokemon in the same way as new_pokemon (or
+// new_arena_pokemon if `arena` is not NULL), except that a name too
+// long to be stored in the Pokemon itself is interned in `pool`, so
+// Pokemon with the same name (and their clones) share one copy of it.
+//
+// A malloced Pokemon holds a reference to the pool until it is
+// destroyed. A Pokemon from an arena does not, so the caller must keep
+// a reference to the pool until the arena is destroyed.
+Pokemon new_interned_pokemon(Arena arena, NamePool pool, int pokemon_id,
+    char *name, double height, double weight, pokemon_type type1,
+    pokemon_type type2);
+
+// Return the arena that the given Pokemon was allocated from, or NULL
+// if it was created with new_pokemon or clone_pokemon.
+Arena pokemon_arena(Pokemon pokemon);
+
 // Create a clone of the given Pokemon.
 //
 // The cloned Pokemon should have all of the same attributes as the
@@ -107,6 +135,18 @@ Pokemon new_pokemon(int pokemon_id, char *name, double height,
 // The cloned Pokemon should be entirely separate from the original
 // Pokemon, such that later deleting the original Pokemon will not
 // affect the cloned Pokemon.
+//
+// The clone is always malloced. It shares the original's attributes
+// (which cannot change once a Pokemon is made) rather than copying
+// them, so cloning takes the same small amount of time for any
+// Pokemon, and the shared attributes are only freed once the original
+// and every clone of it have been destroyed.
+//
+// If the original Pokemon came from an arena, the clone instead gets
+// its own copy of the attributes, since they must outlive the arena.
+// If the original's name is interned in a name pool (see
+// new_interned_pokemon), the clone shares it and holds a reference to
+// the pool instead of copying the name.
 Pokemon clone_pokemon(Pokemon pokemon);
 
 // Return the pokemon_id of a given Pokemon.
@@ -130,6 +170,109 @@ pokemon_type pokemon_first_type(Pokemon pokemon);
 // If the Pokemon only has one type, returns NONE_TYPE.
 pokemon_type pokemon_second_type(Pokemon pokemon);
 
+
+////////////////////////////////////////////////////////////////////////
+//                    Unchecked Pokemon accessors                     //
+////////////////////////////////////////////////////////////////////////
+
+// Each of the functions above checks that it was given a valid Pokemon
+// (not NULL, from new_pokemon and not freed) before reading it, and
+// exits the program with an error message if not.
+//
+// Release builds (built with NDEBUG and without the address sanitizer)
+// instead replace pokemon_id, pokemon_name, pokemon_height,
+// pokemon_weight, pokemon_first_type, pokemon_second_type and
+// pokemon_arena with inline versions that read the Pokemon directly
+// without checking it. Defining POKEMON_UNCHECKED before including this
+// file does the same in any build, and defining POKEMON_CHECKED keeps
+// the checks even with NDEBUG.
+//
+// The checked versions can still be called in an unchecked build by
+// putting the function name in brackets, e.g. (pokemon_id)(pokemon).
+
+#if defined(NDEBUG) && !defined(POKEMON_CHECKED)
+#if !defined(__SANITIZE_ADDRESS__) && !defined(POKEMON_UNCHECKED)
+#define POKEMON_UNCHECKED
+#endif
+#endif
+
+#if defined(POKEMON_UNCHECKED) || defined(POKEMON_IMPLEMENTATION)
+
+// These are the structs that store all of the internal information
+// about a Pokemon. They are only defined here so that the unchecked
+// accessors can be inlined -- you should still only interact with
+// Pokemon via the functions in this file.
+//
+// A Pokemon's attributes are in a pokemon_body, which a Pokemon shares
+// with its clones. Bodies are never changed once they are made, so
+// anything that changes a Pokemon must first give it a body of its own
+// if its body is shared (copy on write).
+//
+// Names shorter than SHORT_NAME_SIZE are kept in short_name, so they
+// need no memory of their own.
+#define SHORT_NAME_SIZE 16
+
+struct pokemon_body {
+    int          references; // Pokemon sharing the body
+    int          pokemon_id;
+    char         *name; // short_name, or a copy of a longer name
+    double       height;
+    double       weight;
+    pokemon_type type1;
+    pokemon_type type2;
+    NamePool     name_pool; // Pool the name is interned in, or NULL
+    Pokemon      owner; // Pokemon whose memory holds the body, NULL if arena
+    char         short_name[SHORT_NAME_SIZE];
+};
+
+struct pokemon {
+    int          magic_number;
+    struct pokemon_body *body;
+    Arena        arena; // Arena the Pokemon came from, NULL if malloced
+};
+
+#endif
+
+#if defined(POKEMON_UNCHECKED) && !defined(POKEMON_IMPLEMENTATION)
+
+static inline int unchecked_pokemon_id(Pokemon pokemon) {
+    return pokemon->body->pokemon_id;
+}
+
+static inline char *unchecked_pokemon_name(Pokemon pokemon) {
+    return pokemon->body->name;
+}
+
+static inline double unchecked_pokemon_height(Pokemon pokemon) {
+    return pokemon->body->height;
+}
+
+static inline double unchecked_pokemon_weight(Pokemon pokemon) {
+    return pokemon->body->weight;
+}
+
+static inline pokemon_type unchecked_pokemon_first_type(Pokemon pokemon) {
+    return pokemon->body->type1;
+}
+
+static inline pokemon_type unchecked_pokemon_second_type(Pokemon pokemon) {
+    return pokemon->body->type2;
+}
+
+static inline Arena unchecked_pokemon_arena(Pokemon pokemon) {
+    return pokemon->arena;
+}
+
+#define pokemon_id(pokemon) unchecked_pokemon_id(pokemon)
+#define pokemon_name(pokemon) unchecked_pokemon_name(pokemon)
+#define pokemon_height(pokemon) unchecked_pokemon_height(pokemon)
+#define pokemon_weight(pokemon) unchecked_pokemon_weight(pokemon)
+#define pokemon_first_type(pokemon) unchecked_pokemon_first_type(pokemon)
+#define pokemon_second_type(pokemon) unchecked_pokemon_second_type(pokemon)
+#define pokemon_arena(pokemon) unchecked_pokemon_arena(pokemon)
+
+#endif
+
 // Free the memory associated with a given Pokemon.
 void destroy_pokemon(Pokemon pokemon);
 
@@ -0,0 +1,210 @@
+// A Pokedex split into shards by pokemon_id, for many writing threads
+//
+// Every shard is a concurrent Pokedex, and a Pokemon always lives in the
+// shard its pokemon_id hashes to, so adding or removing it only locks
+// that shard, and finding it only takes that shard's shared lock.
+// Queries ask every shard in turn and merge the results in order of
+// pokemon_id. Like any Pokedex, every shard runs its bulk operations on
+// the process-wide task pool, so shards do not each start threads.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "sharded_pokedex.h"
+
+#define SHARDS_PER_PROCESSOR 4
+#define MAX_SHARDS 256
+#define CACHE_LINE_SIZE 64
+
+// The kinds of query that can be asked of every shard
+enum shard_query_kind {
+    QUERY_TYPE,
+    QUERY_BOTH_TYPES,
+    QUERY_EITHER_TYPE,
+    QUERY_FOUND,
+    QUERY_SEARCH
+};
+
+struct shard_query {
+    enum shard_query_kind kind;
+    pokemon_type first;
+    pokemon_type second;
+    char *text;
+};
+
+// One shard, on a cache line of its own so that threads using
+// neighbouring shards do not slow each other down
+struct shard {
+    _Alignas(CACHE_LINE_SIZE) Pokedex pokedex;
+};
+
+struct sharded_pokedex {
+    struct shard *shards;
+    int n_shards;
+};
+
+static struct shard *shard_for(ShardedPokedex sharded, int id);
+static Pokedex query_every_shard(ShardedPokedex sharded,
+    struct shard_query query);
+static Pokedex query_shard(Pokedex pokedex, struct shard_query query);
+
+// Creates a sharded Pokedex with n_shards shards (or some per processor)
+ShardedPokedex new_sharded_pokedex(int n_shards) {
+    if (n_shards <= 0) {
+        n_shards = SHARDS_PER_PROCESSOR * sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (n_shards > MAX_SHARDS) {
+        n_shards = MAX_SHARDS;
+    } else if (n_shards < 1) {
+        n_shards = 1;
+    }
+    ShardedPokedex sharded = malloc(sizeof (struct sharded_pokedex));
+    assert(sharded != NULL);
+    sharded->shards = aligned_alloc(CACHE_LINE_SIZE,
+        n_shards * sizeof (struct shard));
+    assert(sharded->shards != NULL);
+    sharded->n_shards = n_shards;
+    int i = 0;
+    while (i < n_shards) {
+        sharded->shards[i].pokedex = new_concurrent_pokedex();
+        i += 1;
+    }
+    return sharded;
+}
+
+// Creates a Pokemon for the shard its pokemon_id belongs to
+Pokemon new_sharded_pokemon(ShardedPokedex sharded, int pokemon_id,
+    char *name, double height, double weight, pokemon_type type1,
+    pokemon_type type2) {
+
+    return new_pokedex_pokemon(shard_for(sharded, pokemon_id)->pokedex,
+        pokemon_id, name, height, weight, type1, type2);
+}
+
+// Adds the Pokemon to the shard its pokemon_id belongs to
+void sharded_add_pokemon(ShardedPokedex sharded, Pokemon pokemon) {
+    add_pokemon(shard_for(sharded, pokemon_id(pokemon))->pokedex, pokemon);
+}
+
+// Sets the Pokemon with pokemon_id = id to be 'found', returning 1 if
+// it is in the Pokedex
+int sharded_find_pokemon(ShardedPokedex sharded, int id) {
+    return find_pokemon_by_id(shard_for(sharded, id)->pokedex, id);
+}
+
+// Removes the Pokemon with pokemon_id = id, returning 1 if it was in
+// the Pokedex
+int sharded_remove_pokemon(ShardedPokedex sharded, int id) {
+    return remove_pokemon_by_id(shard_for(sharded, id)->pokedex, id);
+}
+
+// Returns the number of 'found' Pokemon in every shard
+int sharded_count_found_pokemon(ShardedPokedex sharded) {
+    int found = 0;
+    int i = 0;
+    while (i < sharded->n_shards) {
+        found += count_found_pokemon(sharded->shards[i].pokedex);
+        i += 1;
+    }
+    return found;
+}
+
+// Returns the number of Pokemon in every shard
+int sharded_count_total_pokemon(ShardedPokedex sharded) {
+    int total = 0;
+    int i = 0;
+    while (i < sharded->n_shards) {
+        total += count_total_pokemon(sharded->shards[i].pokedex);
+        i += 1;
+    }
+    return total;
+}
+
+// Makes a new Pokedex with the Pokemon of the given type
+Pokedex sharded_get_pokemon_of_type(ShardedPokedex sharded,
+    pokemon_type type) {
+
+    struct shard_query query = {QUERY_TYPE, type, type, NULL};
+    return query_every_shard(sharded, query);
+}
+
+// Makes a new Pokedex with the Pokemon that have both of the given types
+Pokedex sharded_get_pokemon_of_both_types(ShardedPokedex sharded,
+    pokemon_type first, pokemon_type second) {
+
+    struct shard_query query = {QUERY_BOTH_TYPES, first, second, NULL};
+    return query_every_shard(sharded, query);
+}
+
+// Makes a new Pokedex with the Pokemon that have either of the given types
+Pokedex sharded_get_pokemon_of_either_type(ShardedPokedex sharded,
+    pokemon_type first, pokemon_type second) {
+
+    struct shard_query query = {QUERY_EITHER_TYPE, first, second, NULL};
+    return query_every_shard(sharded, query);
+}
+
+// Makes a new Pokedex with all the 'found' Pokemon
+Pokedex sharded_get_found_pokemon(ShardedPokedex sharded) {
+    struct shard_query query = {QUERY_FOUND, NONE_TYPE, NONE_TYPE, NULL};
+    return query_every_shard(sharded, query);
+}
+
+// Makes a new Pokedex with the Pokemon that have "text" in their name
+Pokedex sharded_search_pokemon(ShardedPokedex sharded, char *text) {
+    struct shard_query query = {QUERY_SEARCH, NONE_TYPE, NONE_TYPE, text};
+    return query_every_shard(sharded, query);
+}
+
+// Destroys every shard and the sharded Pokedex
+void destroy_sharded_pokedex(ShardedPokedex sharded) {
+    int i = 0;
+    while (i < sharded->n_shards) {
+        destroy_pokedex(sharded->shards[i].pokedex);
+        i += 1;
+    }
+    free(sharded->shards);
+    free(sharded);
+}
+
+// Returns the shard that the Pokemon with pokemon_id = id belongs in
+static struct shard *shard_for(ShardedPokedex sharded, int id) {
+    // Multiplying spreads runs of consecutive IDs over every shard
+    unsigned int hash = (unsigned int) id * 2654435761u;
+    return &sharded->shards[(hash >> 16) % sharded->n_shards];
+}
+
+// Asks every shard the query, and merges their results
+static Pokedex query_every_shard(ShardedPokedex sharded,
+    struct shard_query query) {
+
+    Pokedex *results = malloc(sharded->n_shards * sizeof(Pokedex));
+    assert(results != NULL);
+    int i = 0;
+    while (i < sharded->n_shards) {
+        results[i] = query_shard(sharded->shards[i].pokedex, query);
+        i += 1;
+    }
+    Pokedex merged = merge_pokedexes(results, sharded->n_shards);
+    free(results);
+    return merged;
+}
+
+// Asks one shard the query
+static Pokedex query_shard(Pokedex pokedex, struct shard_query query) {
+    if (query.kind == QUERY_TYPE) {
+        return get_pokemon_of_type(pokedex, query.first);
+    } else if (query.kind == QUERY_BOTH_TYPES) {
+        return get_pokemon_of_both_types(pokedex, query.first, query.second);
+    } else if (query.kind == QUERY_EITHER_TYPE) {
+        return get_pokemon_of_either_type(pokedex, query.first, query.second);
+    } else if (query.kind == QUERY_FOUND) {
+        return get_found_pokemon(pokedex);
+    } else {
+        return search_pokemon(pokedex, query.text);
+    }
+}
\ No newline at end of file
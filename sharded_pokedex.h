@@ -0,0 +1,93 @@
+// A Pokedex split into shards by pokemon_id, for many writing threads
+
+#include "pokedex.h"
+
+#ifndef _SHARDED_POKEDEX_H_
+#define _SHARDED_POKEDEX_H_
+
+typedef struct sharded_pokedex *ShardedPokedex;
+
+// Create a new, empty sharded Pokedex made of `n_shards` concurrent
+// Pokedexes (see new_concurrent_pokedex), or four per processor if
+// `n_shards` is 0 or less.
+//
+// Each Pokemon lives in the shard its pokemon_id hashes to, and each
+// shard has its own locks, so threads adding, finding and removing
+// Pokemon in different shards never wait for each other, and threads
+// only finding Pokemon never wait for each other at all. Counting and
+// the get_ and search_ queries visit every shard in turn and merge what
+// they find. A sharded Pokedex has no currently selected Pokemon:
+// Pokemon are found and removed by pokemon_id instead. The shards run
+// their bulk operations on the process-wide task pool (see
+// default_task_pool), like any other Pokedex.
+//
+// Any number of threads can call the functions in this file on it at
+// once. Counts and query results are taken one shard at a time, so
+// while other threads are changing the Pokedex they may include changes
+// to some shards but not others.
+//
+// It is the caller's responsibility to call 'destroy_sharded_pokedex'
+// to free its memory.
+ShardedPokedex new_sharded_pokedex(int n_shards);
+
+// Create a new Pokemon (see new_pokedex_pokemon) for the shard its
+// pokemon_id belongs to, so that it shares that shard's name pool.
+Pokemon new_sharded_pokemon(ShardedPokedex sharded, int pokemon_id,
+    char *name, double height, double weight, pokemon_type type1,
+    pokemon_type type2);
+
+// Add a Pokemon to the shard its pokemon_id belongs to, in the same way
+// as add_pokemon (including exiting if there is already a Pokemon with
+// the same pokemon_id).
+void sharded_add_pokemon(ShardedPokedex sharded, Pokemon pokemon);
+
+// Set the Pokemon with the given pokemon_id to be 'found'.
+//
+// Returns 1 if there is a Pokemon with that pokemon_id, or 0 if not.
+int sharded_find_pokemon(ShardedPokedex sharded, int id);
+
+// Remove the Pokemon with the given pokemon_id and free its memory, in
+// the same way as remove_pokemon.
+//
+// Returns 1 if there was a Pokemon with that pokemon_id, or 0 if not.
+int sharded_remove_pokemon(ShardedPokedex sharded, int id);
+
+// Return the number of 'found' Pokemon in every shard.
+int sharded_count_found_pokemon(ShardedPokedex sharded);
+
+// Return the number of Pokemon in every shard.
+int sharded_count_total_pokemon(ShardedPokedex sharded);
+
+// Create a new Pokedex holding copies of the found Pokemon of the
+// given type from every shard, in the same way as get_pokemon_of_type,
+// except that they are in ascending order of pokemon_id (the order
+// they were added in is not kept across shards).
+Pokedex sharded_get_pokemon_of_type(ShardedPokedex sharded,
+    pokemon_type type);
+
+// Create a new Pokedex of the found Pokemon with both of the given
+// types from every shard, in the same way as get_pokemon_of_both_types,
+// in ascending order of pokemon_id.
+Pokedex sharded_get_pokemon_of_both_types(ShardedPokedex sharded,
+    pokemon_type first, pokemon_type second);
+
+// Create a new Pokedex of the found Pokemon with either of the given
+// types from every shard, in the same way as
+// get_pokemon_of_either_type, in ascending order of pokemon_id.
+Pokedex sharded_get_pokemon_of_either_type(ShardedPokedex sharded,
+    pokemon_type first, pokemon_type second);
+
+// Create a new Pokedex of the found Pokemon from every shard, in the
+// same way as get_found_pokemon.
+Pokedex sharded_get_found_pokemon(ShardedPokedex sharded);
+
+// Create a new Pokedex of the found Pokemon with the given text in
+// their name from every shard, in the same way as search_pokemon, in
+// ascending order of pokemon_id.
+Pokedex sharded_search_pokemon(ShardedPokedex sharded, char *text);
+
+// Free all of the memory used by the sharded Pokedex and its Pokemon,
+// once no other thread is using it.
+void destroy_sharded_pokedex(ShardedPokedex sharded);
+
+#endif // _SHARDED_POKEDEX_H_
\ No newline at end of file
@@ -0,0 +1,309 @@
+// Work-stealing pool of threads shared by bulk Pokedex operations
+//
+// Every worker has a deque of tasks, each a ring buffer behind a mutex
+// of its own. task_pool_run deals its chunks out over the deques and
+// wakes the workers, then runs tasks itself until none are left to
+// take, and sleeps until the rest of its chunks are done.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "task_pool.h"
+
+#define MAX_POOL_THREADS 64
+#define INITIAL_DEQUE_CAPACITY 64
+
+static TaskPool default_pool = NULL;
+static pthread_once_t default_pool_made = PTHREAD_ONCE_INIT;
+
+// One call of task_pool_run, shared by its tasks
+struct task_batch {
+    task_function function;
+    void *arg;
+    int remaining; // Number of the call's tasks not yet finished
+};
+
+struct task {
+    struct task_batch *batch;
+    int chunk;
+};
+
+// A worker's tasks, which it takes from the back while other threads
+// steal from the front
+struct task_deque {
+    TaskPool pool;
+    int index; // Index of the deque's worker in the pool
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    struct task *tasks; // Ring buffer of `capacity` tasks
+    int capacity; // Always zero or a power of two
+    int front;
+    int length;
+};
+
+struct task_pool {
+    int n_threads;
+    struct task_deque *deques; // One per worker
+    int n_deques;
+    int next_deque; // Deque the next call's chunks are first dealt to
+
+    pthread_mutex_t mutex; // Held to sleep on, or to wake, the conditions
+    pthread_cond_t work_ready; // Signalled when tasks are queued or the
+                               // pool is stopping
+    pthread_cond_t batch_done; // Signalled when a call's last task ends
+    int queued; // Number of tasks in the deques
+    int stopping;
+};
+
+static void make_default_pool(void);
+static void *run_worker(void *deque);
+static int take_task(TaskPool pool, int own, struct task *task);
+static void run_task(TaskPool pool, struct task task);
+static void push_task(struct task_deque *deque, struct task task);
+static int pop_back(struct task_deque *deque, struct task *task);
+static int pop_front(struct task_deque *deque, struct task *task);
+
+// Returns the pool with a thread per processor that is shared by the
+// whole process, making it the first time it is asked for
+TaskPool default_task_pool(void) {
+    pthread_once(&default_pool_made, make_default_pool);
+    return default_pool;
+}
+
+// Creates a pool that runs tasks on n_threads threads at once
+TaskPool new_task_pool(int n_threads) {
+    if (n_threads <= 0) {
+        n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (n_threads > MAX_POOL_THREADS) {
+        n_threads = MAX_POOL_THREADS;
+    } else if (n_threads < 1) {
+        n_threads = 1;
+    }
+    TaskPool pool = malloc(sizeof (struct task_pool));
+    assert(pool != NULL);
+    pool->n_threads = n_threads;
+    pool->n_deques = n_threads - 1;
+    pool->next_deque = 0;
+    pool->queued = 0;
+    pool->stopping = 0;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->batch_done, NULL);
+    pool->deques = NULL;
+    if (pool->n_deques > 0) {
+        pool->deques = malloc(pool->n_deques * sizeof(struct task_deque));
+        assert(pool->deques != NULL);
+    }
+    int i = 0;
+    while (i < pool->n_deques) {
+        struct task_deque *deque = &pool->deques[i];
+        deque->pool = pool;
+        deque->index = i;
+        pthread_mutex_init(&deque->mutex, NULL);
+        deque->tasks = NULL;
+        deque->capacity = 0;
+        deque->front = 0;
+        deque->length = 0;
+        i += 1;
+    }
+    // Every deque is ready before any worker can steal from it
+    i = 0;
+    while (i < pool->n_deques) {
+        if (pthread_create(&pool->deques[i].thread, NULL, run_worker,
+            &pool->deques[i]) != 0) {
+            fprintf(stderr, "Cannot start task pool worker.\n");
+            exit(1);
+        }
+        i += 1;
+    }
+    return pool;
+}
+
+// Returns the number of threads the pool runs tasks on
+int task_pool_threads(TaskPool pool) {
+    return pool->n_threads;
+}
+
+// Runs function(arg, chunk) for every chunk, returning once all are done
+void task_pool_run(TaskPool pool, int n_chunks, task_function function,
+    void *arg) {
+
+    if (pool->n_deques == 0 || n_chunks <= 1) {
+        int chunk = 0;
+        while (chunk < n_chunks) {
+            function(arg, chunk);
+            chunk += 1;
+        }
+        return;
+    }
+
+    struct task_batch batch = {function, arg, n_chunks};
+    pthread_mutex_lock(&pool->mutex);
+    int deque = pool->next_deque;
+    pool->next_deque = (deque + n_chunks) % pool->n_deques;
+    int chunk = 0;
+    while (chunk < n_chunks) {
+        struct task task = {&batch, chunk};
+        push_task(&pool->deques[deque], task);
+        deque = (deque + 1) % pool->n_deques;
+        chunk += 1;
+    }
+    __atomic_add_fetch(&pool->queued, n_chunks, __ATOMIC_RELAXED);
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->mutex);
+
+    // Helps with whatever is left, then waits for the chunks that other
+    // threads are still running
+    struct task task;
+    while (take_task(pool, -1, &task)) {
+        run_task(pool, task);
+    }
+    pthread_mutex_lock(&pool->mutex);
+    while (__atomic_load_n(&batch.remaining, __ATOMIC_ACQUIRE) > 0) {
+        pthread_cond_wait(&pool->batch_done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+// Stops every worker and frees the pool
+void destroy_task_pool(TaskPool pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->mutex);
+    // Workers still running may steal from any deque, so every one has
+    // stopped before any deque is freed
+    int i = 0;
+    while (i < pool->n_deques) {
+        pthread_join(pool->deques[i].thread, NULL);
+        i += 1;
+    }
+    i = 0;
+    while (i < pool->n_deques) {
+        pthread_mutex_destroy(&pool->deques[i].mutex);
+        free(pool->deques[i].tasks);
+        i += 1;
+    }
+    free(pool->deques);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->batch_done);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+}
+
+// Makes the pool default_task_pool returns, once
+static void make_default_pool(void) {
+    default_pool = new_task_pool(0);
+}
+
+// Runs tasks from the worker's own deque, or stolen from the others,
+// sleeping while there are none, until the pool stops
+static void *run_worker(void *deque) {
+    struct task_deque *own = deque;
+    TaskPool pool = own->pool;
+    while (1) {
+        struct task task;
+        if (take_task(pool, own->index, &task)) {
+            run_task(pool, task);
+        } else {
+            pthread_mutex_lock(&pool->mutex);
+            while (__atomic_load_n(&pool->queued, __ATOMIC_RELAXED) == 0 &&
+                !pool->stopping) {
+                pthread_cond_wait(&pool->work_ready, &pool->mutex);
+            }
+            int stop = pool->stopping &&
+                __atomic_load_n(&pool->queued, __ATOMIC_RELAXED) == 0;
+            pthread_mutex_unlock(&pool->mutex);
+            if (stop) {
+                return NULL;
+            }
+        }
+    }
+}
+
+// Takes a task from the back of deque `own` (-1 for a thread that is
+// not a worker), or else steals one from the front of another deque.
+// Returns 0 if every deque is empty.
+static int take_task(TaskPool pool, int own, struct task *task) {
+    int taken = 0;
+    if (own >= 0) {
+        taken = pop_back(&pool->deques[own], task);
+    }
+    int i = 1;
+    while (!taken && i <= pool->n_deques) {
+        taken = pop_front(&pool->deques[(own + i) % pool->n_deques], task);
+        i += 1;
+    }
+    if (taken) {
+        __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_RELAXED);
+    }
+    return taken;
+}
+
+// Runs the task, waking its caller if it was the call's last
+static void run_task(TaskPool pool, struct task task) {
+    struct task_batch *batch = task.batch;
+    batch->function(batch->arg, task.chunk);
+    // The batch belongs to the caller, and is gone once it sees this
+    if (__atomic_sub_fetch(&batch->remaining, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&pool->mutex);
+        pthread_cond_broadcast(&pool->batch_done);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+// Adds the task to the back of the deque, doubling its space if full
+static void push_task(struct task_deque *deque, struct task task) {
+    pthread_mutex_lock(&deque->mutex);
+    if (deque->length == deque->capacity) {
+        int capacity = deque->capacity * 2;
+        if (capacity == 0) {
+            capacity = INITIAL_DEQUE_CAPACITY;
+        }
+        struct task *tasks = malloc(capacity * sizeof(struct task));
+        assert(tasks != NULL);
+        int i = 0;
+        while (i < deque->length) {
+            tasks[i] = deque->tasks[(deque->front + i) & (deque->capacity - 1)];
+            i += 1;
+        }
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->capacity = capacity;
+        deque->front = 0;
+    }
+    int back = (deque->front + deque->length) & (deque->capacity - 1);
+    deque->tasks[back] = task;
+    deque->length += 1;
+    pthread_mutex_unlock(&deque->mutex);
+}
+
+// Takes the task at the back of the deque, returning 0 if it is empty
+static int pop_back(struct task_deque *deque, struct task *task) {
+    pthread_mutex_lock(&deque->mutex);
+    int taken = deque->length > 0;
+    if (taken) {
+        deque->length -= 1;
+        *task = deque->tasks[(deque->front + deque->length) &
+            (deque->capacity - 1)];
+    }
+    pthread_mutex_unlock(&deque->mutex);
+    return taken;
+}
+
+// Takes the task at the front of the deque, returning 0 if it is empty
+static int pop_front(struct task_deque *deque, struct task *task) {
+    pthread_mutex_lock(&deque->mutex);
+    int taken = deque->length > 0;
+    if (taken) {
+        *task = deque->tasks[deque->front];
+        deque->front = (deque->front + 1) & (deque->capacity - 1);
+        deque->length -= 1;
+    }
+    pthread_mutex_unlock(&deque->mutex);
+    return taken;
+}
\ No newline at end of file
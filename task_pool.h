@@ -0,0 +1,49 @@
+// Work-stealing pool of threads shared by bulk Pokedex operations
+
+#ifndef _TASK_POOL_H_
+#define _TASK_POOL_H_
+
+typedef struct task_pool *TaskPool;
+
+// Work to be run by a pool, one chunk at a time: handles chunk `chunk`
+// of whatever `arg` describes.
+typedef void (*task_function)(void *arg, int chunk);
+
+// Create a new pool that runs tasks on `n_threads` threads at once, or
+// on one per processor if `n_threads` is 0. The thread calling
+// task_pool_run is one of them, so `n_threads - 1` workers are started,
+// and a pool of one thread runs every task on the caller.
+//
+// The workers sleep while there is nothing to run. It is the caller's
+// responsibility to call 'destroy_task_pool' once nothing uses it.
+TaskPool new_task_pool(int n_threads);
+
+// Return the pool shared by the whole process, which runs tasks on one
+// thread per processor. It is made the first time this is called (from
+// any thread), and lasts until the program exits, so it must never be
+// passed to destroy_task_pool.
+TaskPool default_task_pool(void);
+
+// Return the number of threads the pool runs tasks on.
+int task_pool_threads(TaskPool pool);
+
+// Call function(arg, chunk) once for every chunk from 0 to
+// `n_chunks - 1`, and return once every call has returned.
+//
+// The chunks are dealt out over the workers' deques, and the calling
+// thread runs tasks too while it waits. A worker takes tasks from the
+// back of its own deque, and when that is empty steals them from the
+// front of another's, so workers given slow chunks do not hold up the
+// rest. The calls may run in any order and at the same time, so they
+// must not change anything another chunk uses.
+//
+// Any number of threads can call this at once on the same pool, and a
+// task can itself call it.
+void task_pool_run(TaskPool pool, int n_chunks, task_function function,
+    void *arg);
+
+// Stop every worker of the pool, once no task is left to run, and free
+// the pool.
+void destroy_task_pool(TaskPool pool);
+
+#endif // _TASK_POOL_H_
\ No newline at end of file
@@ -4,8 +4,13 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
 
 #include "pokedex.h"
+#include "csv_import.h"
+#include "sharded_pokedex.h"
 
 // Sample data on Bulbasaur, the Pokemon with pokemon_id 1.
 #define BULBASAUR_ID 1
@@ -79,17 +84,48 @@
 #define WEEZING_FIRST_TYPE POISON_TYPE
 #define WEEZING_SECOND_TYPE NONE_TYPE
 
+// Leading fields of the structs in pokedex.c, so the tests can inspect
+// the Pokedex directly.
 struct pokedex {
     struct pokenode *head;
+    struct pokenode *tail;
+    struct pokenode *selected;
+
+    int total;
+    int found;
 };
 
 struct pokenode {
     struct pokenode *next;
+    struct pokenode *prev;
     struct pokenode *evolution;
 
+    struct pokenode *first_from;
+    struct pokenode *next_from;
+    struct pokenode *prev_from;
+    struct pokenode *chain_root;
+
     Pokemon         pokemon;
-    int selected;
-    int found;
+    int slot;
+};
+
+// What one thread of test_concurrent_pokedex does to the Pokedex: add
+// n_pokemon Pokemon with IDs from first_id, and remove them again if
+// remove is set, or read it n_pokemon times if reader is set
+struct concurrent_test_thread {
+    Pokedex pokedex;
+    int first_id;
+    int n_pokemon;
+    int remove;
+    int reader;
+};
+
+// What the tasks of test_task_pools count: how many times each chunk
+// of the outer and the nested task_pool_run calls has run
+struct pool_test_counts {
+    TaskPool pool;
+    int outer[100];
+    int nested[100][10];
 };
 
 static Pokemon create_venusaur(void);
@@ -112,13 +148,42 @@ static void test_remove_pokemon(void);
 static void test_go_exploring(void);
 static void test_add_pokemon_evolution(void);
 static void test_get_pokemon_of_type(void);
+static void test_get_pokemon_of_both_types(void);
+static void test_get_pokemon_of_either_type(void);
 static void test_search_pokemon(void);
+static void test_arena_pokedex(void);
+static void test_pokedex_views(void);
+static void test_exploring_modes(void);
+static void test_view_found_pokemon_in_range(void);
+static void test_save_and_load_pokedex(void);
+static void test_import_pokedex(void);
+static void test_pokemon_type_from_string(void);
+static void test_interned_names(void);
+static void test_shared_clones(void);
+static void test_pack_pokedex(void);
+static void test_concurrent_pokedex(void);
+static void test_pokedex_cursors(void);
+static void test_sharded_pokedex(void);
+static void test_concurrent_exploring(void);
+static void test_parallel_queries(void);
+static void test_task_pools(void);
+static void test_evolution_graph(void);
+static void test_pokemon_by_id(void);
 
 // Helper functions for creating/comparing Pokemon.
+static Pokedex create_nine_pokemon_pokedex(void);
+static void write_test_file(char *path, char *text);
 static Pokemon create_bulbasaur(void);
 static Pokemon create_ivysaur(void);
 static int is_same_pokemon(Pokemon first, Pokemon second);
 static int is_copied_pokemon(Pokemon first, Pokemon second);
+static void *use_concurrently(void *thread);
+static void *add_sharded_pokemon(void *sharded);
+static void *explore_concurrently(void *pokedex);
+static int is_same_view(PokedexView first, PokedexView second);
+static void count_outer_chunk(void *counts, int chunk);
+static void count_nested_chunk(void *counts, int chunk);
+static Pokedex create_exploring_pokedex(int n_pokemon);
 
 
 
@@ -136,8 +201,28 @@ int main(int argc, char *argv[]) {
     test_go_exploring();
     test_add_pokemon_evolution();
     test_get_pokemon_of_type();
+    test_get_pokemon_of_both_types();
+    test_get_pokemon_of_either_type();
     test_get_found_pokemon();
     test_search_pokemon();
+    test_arena_pokedex();
+    test_pokedex_views();
+    test_exploring_modes();
+    test_view_found_pokemon_in_range();
+    test_save_and_load_pokedex();
+    test_import_pokedex();
+    test_pokemon_type_from_string();
+    test_interned_names();
+    test_shared_clones();
+    test_pack_pokedex();
+    test_concurrent_pokedex();
+    test_pokedex_cursors();
+    test_sharded_pokedex();
+    test_concurrent_exploring();
+    test_parallel_queries();
+    test_task_pools();
+    test_evolution_graph();
+    test_pokemon_by_id();
 
     printf("\nAll Pokedex tests passed, you are Awesome!\n");
 }
@@ -247,16 +332,20 @@ static void test_add_pokemon(void) {
     add_pokemon(pokedex, weezing);
     
     printf("    ... Checking selected Pokemon\n");
+    // Check that the first pokemon added is still selected
+    assert(pokedex->selected == pokedex->head);
+    assert(is_same_pokemon(get_current_pokemon(pokedex), bulbasaur));
+    
+    printf("    ... Checking the Pokedex is linked in both directions\n");
     struct pokenode *curr = pokedex->head;
-    // Check that only first pokemon added is selected
-    while (curr != NULL) {
-        if (curr == pokedex->head) {
-            assert(curr->selected == 1);
-        } else {
-            assert(curr->selected == 0);
-        }
+    assert(curr->prev == NULL);
+    while (curr->next != NULL) {
+        assert(curr->next->prev == curr);
         curr = curr->next;
     }
+    assert(is_same_pokemon(curr->pokemon, weezing));
+    assert(pokedex->tail == curr);
+    assert(count_total_pokemon(pokedex) == 9);
     
     printf("    ... Checking all Pokemon are not found\n");
     assert(count_found_pokemon(pokedex) == 0);
@@ -610,8 +699,10 @@ static void test_go_exploring(void) {
     assert(count_found_pokemon(pokedex) == 1);
     
     printf("       --> Checking that Bulbasaur #001 is the only found Pokemon\n");
-    assert(is_same_pokemon(pokedex->head->pokemon, bulbasaur));
-    assert(pokedex->head->found == 1);
+    Pokedex found_pokedex = get_found_pokemon(pokedex);
+    assert(count_total_pokemon(found_pokedex) == 1);
+    assert(is_copied_pokemon(found_pokedex->head->pokemon, bulbasaur));
+    destroy_pokedex(found_pokedex);
     
     printf("    ... Going exploring for one Pokemon using factor '3' and a seed '3'\n");
     // Ivysaur must be found if the program is running correctly since
@@ -623,8 +714,10 @@ static void test_go_exploring(void) {
     assert(count_found_pokemon(pokedex) == 2);
     
     printf("       --> Checking that Ivysaur #002 is now also found\n");
-    assert(is_same_pokemon(pokedex->head->next->pokemon, ivysaur));
-    assert(pokedex->head->next->found == 1);
+    found_pokedex = get_found_pokemon(pokedex);
+    assert(count_total_pokemon(found_pokedex) == 2);
+    assert(is_copied_pokemon(found_pokedex->head->next->pokemon, ivysaur));
+    destroy_pokedex(found_pokedex);
     
     printf("    ... Going exploring for four Pokemon using factor '999'\n");
     printf("    ... and a seed '2'\n");
@@ -792,6 +885,106 @@ static void test_get_pokemon_of_type(void) {
     printf(">> Passed get_pokemon_of_type tests!\n");
 }
 
+// `test_get_pokemon_of_both_types` checks whether the
+// get_pokemon_of_both_types function works correctly.
+//
+// It creates Bulbasaur (Grass Poison), Venusaur (Poison Grass), Ekans
+// (Poison) and Rattata (Normal), finds all of them except Venusaur, and
+// checks that asking for Grass and Poison Pokemon only returns a copy of
+// Bulbasaur, whichever order the types are given in.
+static void test_get_pokemon_of_both_types(void) {
+    printf("\n>> Testing get_pokemon_of_both_types\n");
+
+    printf("    ... Creating a new Pokedex\n");
+    Pokedex pokedex = new_pokedex();
+
+    printf("    ... Adding Bulbasaur, Venusaur, Ekans and Rattata to the Pokedex\n");
+    Pokemon bulbasaur = create_bulbasaur();
+    add_pokemon(pokedex, bulbasaur);
+    add_pokemon(pokedex, create_venusaur());
+    add_pokemon(pokedex, create_ekans());
+    add_pokemon(pokedex, create_rattata());
+
+    printf("    ... Setting every Pokemon except Venusaur to be found\n");
+    find_current_pokemon(pokedex);
+    next_pokemon(pokedex);
+    next_pokemon(pokedex);
+    find_current_pokemon(pokedex);
+    next_pokemon(pokedex);
+    find_current_pokemon(pokedex);
+
+    printf("    ... Getting all found Grass and Poison type Pokemon into a new Pokedex\n");
+    Pokedex both_pokedex = get_pokemon_of_both_types(pokedex, GRASS_TYPE, POISON_TYPE);
+
+    printf("       --> Checking that only Bulbasaur was copied\n");
+    assert(count_total_pokemon(both_pokedex) == 1);
+    assert(count_found_pokemon(both_pokedex) == 1);
+    assert(is_copied_pokemon(get_current_pokemon(both_pokedex), bulbasaur));
+    destroy_pokedex(both_pokedex);
+
+    printf("       --> Checking that the order of the types does not matter\n");
+    both_pokedex = get_pokemon_of_both_types(pokedex, POISON_TYPE, GRASS_TYPE);
+    assert(count_total_pokemon(both_pokedex) == 1);
+    assert(is_copied_pokemon(get_current_pokemon(both_pokedex), bulbasaur));
+    destroy_pokedex(both_pokedex);
+
+    printf("       --> Checking that no Pokemon are both Normal and Poison type\n");
+    both_pokedex = get_pokemon_of_both_types(pokedex, NORMAL_TYPE, POISON_TYPE);
+    assert(count_total_pokemon(both_pokedex) == 0);
+    destroy_pokedex(both_pokedex);
+
+    printf("    ... Destroying the Pokedex\n");
+    destroy_pokedex(pokedex);
+
+    printf(">> Passed get_pokemon_of_both_types tests!\n");
+}
+
+// `test_get_pokemon_of_either_type` checks whether the
+// get_pokemon_of_either_type function works correctly.
+//
+// It creates Rattata (Normal), Bulbasaur (Grass Poison), Raticate
+// (Normal) and Ekans (Poison), finds all of them except Raticate, and
+// checks that asking for Normal or Grass Pokemon returns copies of
+// Rattata and Bulbasaur in Pokedex order.
+static void test_get_pokemon_of_either_type(void) {
+    printf("\n>> Testing get_pokemon_of_either_type\n");
+
+    printf("    ... Creating a new Pokedex\n");
+    Pokedex pokedex = new_pokedex();
+
+    printf("    ... Adding Rattata, Bulbasaur, Raticate and Ekans to the Pokedex\n");
+    Pokemon rattata = create_rattata();
+    Pokemon bulbasaur = create_bulbasaur();
+    add_pokemon(pokedex, rattata);
+    add_pokemon(pokedex, bulbasaur);
+    add_pokemon(pokedex, create_raticate());
+    add_pokemon(pokedex, create_ekans());
+
+    printf("    ... Setting every Pokemon except Raticate to be found\n");
+    find_current_pokemon(pokedex);
+    next_pokemon(pokedex);
+    find_current_pokemon(pokedex);
+    next_pokemon(pokedex);
+    next_pokemon(pokedex);
+    find_current_pokemon(pokedex);
+
+    printf("    ... Getting all found Normal or Grass type Pokemon into a new Pokedex\n");
+    Pokedex either_pokedex = get_pokemon_of_either_type(pokedex, NORMAL_TYPE, GRASS_TYPE);
+
+    printf("       --> Checking that Rattata and Bulbasaur were copied in order\n");
+    assert(count_total_pokemon(either_pokedex) == 2);
+    assert(count_found_pokemon(either_pokedex) == 2);
+    assert(is_copied_pokemon(get_current_pokemon(either_pokedex), rattata));
+    next_pokemon(either_pokedex);
+    assert(is_copied_pokemon(get_current_pokemon(either_pokedex), bulbasaur));
+
+    printf("    ... Destroying both Pokedexes\n");
+    destroy_pokedex(either_pokedex);
+    destroy_pokedex(pokedex);
+
+    printf(">> Passed get_pokemon_of_either_type tests!\n");
+}
+
 // `test_get_found_pokemon` checks whether the get_found_pokemon
 // function works correctly.
 //
@@ -926,6 +1119,13 @@ static void test_get_found_pokemon(void) {
 //
 // It will also check if an empty pokedex is returned when there are no matching
 // pokemon.
+//
+// It then adds a found Pokemon whose name is longer than the blocks the
+// matcher compares at once, and searches for text at its end.
+//
+// Finally it adds Porygon2, whose name has a digit in it, to this
+// Pokedex and to a concurrent Pokedex (which indexes names as they are
+// added), and checks that searching for text with the digit finds it.
 static void test_search_pokemon(void) {
     printf("\n>> Testing search_pokemon\n");
 
@@ -1049,18 +1249,1691 @@ static void test_search_pokemon(void) {
 
     printf("       --> Checking that an empty Pokedex is returned\n");
     assert(count_total_pokemon(search_pokedex) == 0);
-    
+    destroy_pokedex(search_pokedex);
+
+    printf("    ... Getting all Pokemon with 'r4' in the name into a new Pokedex\n");
+    search_pokedex = search_pokemon(pokedex, "r4");
+
+    printf("       --> Checking that an empty Pokedex is returned\n");
+    assert(count_total_pokemon(search_pokedex) == 0);
+    destroy_pokedex(search_pokedex);
+
+    printf("    ... Adding and finding a Pokemon with a 41 character name\n");
+    add_pokemon(pokedex, new_pokemon(999, "Long Named-Pokemon With Far Too Many Tail",
+        1.0, 10.0, NORMAL_TYPE, NONE_TYPE));
+    change_current_pokemon(pokedex, 999);
+    find_current_pokemon(pokedex);
+
+    printf("    ... Getting all Pokemon with 'many tAIL' in the name into a new Pokedex\n");
+    search_pokedex = search_pokemon(pokedex, "many tAIL");
+
+    printf("       --> Checking that only the long named Pokemon is returned\n");
+    assert(count_total_pokemon(search_pokedex) == 1);
+    assert(pokemon_id(get_current_pokemon(search_pokedex)) == 999);
+    destroy_pokedex(search_pokedex);
+
+    printf("    ... Adding and finding Porygon2\n");
+    add_pokemon(pokedex, new_pokemon(233, "Porygon2", 0.6, 32.5,
+        NORMAL_TYPE, NONE_TYPE));
+    change_current_pokemon(pokedex, 233);
+    find_current_pokemon(pokedex);
+
+    printf("    ... Getting all Pokemon with 'GON2' in the name into a new Pokedex\n");
+    search_pokedex = search_pokemon(pokedex, "GON2");
+
+    printf("       --> Checking that only Porygon2 is returned\n");
+    assert(count_total_pokemon(search_pokedex) == 1);
+    assert(pokemon_id(get_current_pokemon(search_pokedex)) == 233);
+    destroy_pokedex(search_pokedex);
+
+    printf("       --> Checking that 'n\x12' does not match Porygon2\n");
+    search_pokedex = search_pokemon(pokedex, "n\x12");
+    assert(count_total_pokemon(search_pokedex) == 0);
+    destroy_pokedex(search_pokedex);
+
+    printf("    ... Adding and finding Porygon2 in a concurrent Pokedex\n");
+    Pokedex concurrent = new_concurrent_pokedex();
+    add_pokemon(concurrent, new_pokemon(233, "Porygon2", 0.6, 32.5,
+        NORMAL_TYPE, NONE_TYPE));
+    find_current_pokemon(concurrent);
+
+    printf("       --> Checking that searching for '2' finds Porygon2\n");
+    search_pokedex = search_pokemon(concurrent, "2");
+    assert(count_total_pokemon(search_pokedex) == 1);
+    destroy_pokedex(search_pokedex);
+    destroy_pokedex(concurrent);
+
+    printf("    ... Destroying the Pokedex\n");
+    destroy_pokedex(pokedex);
+
+    printf(">> Passed search_pokemon tests!\n");
+}
+
+// `test_arena_pokedex` checks whether a Pokedex created with
+// new_arena_pokedex behaves the same as one created with new_pokedex.
+//
+// It creates Bulbasaur, Ivysaur and Venusaur with new_pokedex_pokemon
+// (so they live in the Pokedex's arena) and Rattata with new_pokemon,
+// adds them all, then checks navigating, removing (including adding a
+// Pokemon after a removal, which reuses the removed pokenode) and
+// copying the Pokedex.
+//
+// Destroying the Pokedex must free Rattata as well as the arena.
+static void test_arena_pokedex(void) {
+    printf("\n>> Testing new_arena_pokedex\n");
+
+    printf("    ... Creating a new arena Pokedex\n");
+    Pokedex pokedex = new_arena_pokedex();
+    assert(pokedex != NULL);
+
+    printf("    ... Creating Bulbasaur, Ivysaur and Venusaur in the arena\n");
+    Pokemon bulbasaur = new_pokedex_pokemon(pokedex,
+        BULBASAUR_ID, BULBASAUR_NAME,
+        BULBASAUR_HEIGHT, BULBASAUR_WEIGHT,
+        BULBASAUR_FIRST_TYPE, BULBASAUR_SECOND_TYPE);
+    Pokemon ivysaur = new_pokedex_pokemon(pokedex,
+        IVYSAUR_ID, IVYSAUR_NAME,
+        IVYSAUR_HEIGHT, IVYSAUR_WEIGHT,
+        IVYSAUR_FIRST_TYPE, IVYSAUR_SECOND_TYPE);
+    Pokemon venusaur = new_pokedex_pokemon(pokedex,
+        VENUSAUR_ID, VENUSAUR_NAME,
+        VENUSAUR_HEIGHT, VENUSAUR_WEIGHT,
+        VENUSAUR_FIRST_TYPE, VENUSAUR_SECOND_TYPE);
+    assert(pokemon_arena(bulbasaur) != NULL);
+
+    printf("    ... Creating Rattata with new_pokemon\n");
+    Pokemon rattata = create_rattata();
+    assert(pokemon_arena(rattata) == NULL);
+
+    printf("    ... Adding Bulbasaur, Ivysaur, Rattata and Venusaur to the Pokedex\n");
+    add_pokemon(pokedex, bulbasaur);
+    add_pokemon(pokedex, ivysaur);
+    add_pokemon(pokedex, rattata);
+    add_pokemon(pokedex, venusaur);
+    assert(count_total_pokemon(pokedex) == 4);
+
+    printf("       --> Checking that the Pokemon keep their attributes\n");
+    assert(is_same_pokemon(get_current_pokemon(pokedex), bulbasaur));
+    assert(pokemon_id(bulbasaur) == BULBASAUR_ID);
+    assert(pokemon_height(bulbasaur) == BULBASAUR_HEIGHT);
+    assert(pokemon_first_type(bulbasaur) == BULBASAUR_FIRST_TYPE);
+
+    printf("    ... Finding Bulbasaur and Ivysaur\n");
+    find_current_pokemon(pokedex);
+    next_pokemon(pokedex);
+    find_current_pokemon(pokedex);
+
+    printf("    ... Removing Ivysaur from the Pokedex\n");
+    remove_pokemon(pokedex);
+    assert(count_total_pokemon(pokedex) == 3);
+    assert(count_found_pokemon(pokedex) == 1);
+
+    printf("       --> Checking that the current Pokemon is Rattata\n");
+    assert(is_same_pokemon(get_current_pokemon(pokedex), rattata));
+
+    printf("    ... Adding Raticate after the removal\n");
+    Pokemon raticate = new_pokedex_pokemon(pokedex,
+        RATICATE_ID, RATICATE_NAME,
+        RATICATE_HEIGHT, RATICATE_WEIGHT,
+        RATICATE_FIRST_TYPE, RATICATE_SECOND_TYPE);
+    add_pokemon(pokedex, raticate);
+    assert(count_total_pokemon(pokedex) == 4);
+    change_current_pokemon(pokedex, RATICATE_ID);
+    assert(is_same_pokemon(get_current_pokemon(pokedex), raticate));
+
+    printf("    ... Copying the found Pokemon into a new Pokedex\n");
+    Pokedex found_pokedex = get_found_pokemon(pokedex);
+    assert(count_total_pokemon(found_pokedex) == 1);
+
+    printf("       --> Checking that the copy does not come from the arena\n");
+    Pokemon copy = get_current_pokemon(found_pokedex);
+    assert(is_copied_pokemon(copy, bulbasaur));
+    assert(pokemon_arena(copy) == NULL);
+
     printf("    ... Destroying both Pokedexes\n");
     destroy_pokedex(pokedex);
+    destroy_pokedex(found_pokedex);
+
+    printf(">> Passed new_arena_pokedex tests!\n");
+}
+
+// `test_pokedex_views` checks whether the PokedexView functions work
+// correctly.
+//
+// It adds Rattata, Bulbasaur, Raticate and Ekans, finds all of them
+// except Raticate, and views the Normal or Poison Pokemon. The view
+// must hold Rattata, Bulbasaur and Ekans themselves (not copies), and
+// moving through it must not move the Pokedex's selected Pokemon.
+//
+// It then checks that views of the found Pokemon are in pokemon_id
+// order, that a search with no matches gives an empty view, and that
+// materializing a view gives the same Pokedex as search_pokemon.
+static void test_pokedex_views(void) {
+    printf("\n>> Testing Pokedex views\n");
+
+    printf("    ... Creating a new Pokedex\n");
+    Pokedex pokedex = new_pokedex();
+
+    printf("    ... Adding Rattata, Bulbasaur, Raticate and Ekans to the Pokedex\n");
+    Pokemon rattata = create_rattata();
+    Pokemon bulbasaur = create_bulbasaur();
+    Pokemon ekans = create_ekans();
+    add_pokemon(pokedex, rattata);
+    add_pokemon(pokedex, bulbasaur);
+    add_pokemon(pokedex, create_raticate());
+    add_pokemon(pokedex, ekans);
+
+    printf("    ... Setting every Pokemon except Raticate to be found\n");
+    find_current_pokemon(pokedex);
+    next_pokemon(pokedex);
+    find_current_pokemon(pokedex);
+    next_pokemon(pokedex);
+    next_pokemon(pokedex);
+    find_current_pokemon(pokedex);
+
+    printf("    ... Viewing all found Normal or Poison type Pokemon\n");
+    PokedexView view = view_pokemon_of_either_type(pokedex, NORMAL_TYPE, POISON_TYPE);
+
+    printf("       --> Checking that the view refers to the original Pokemon\n");
+    assert(view_count(view) == 3);
+    assert(view_current_pokemon(view) == rattata);
+    view_next_pokemon(view);
+    assert(view_current_pokemon(view) == bulbasaur);
+    view_next_pokemon(view);
+    assert(view_current_pokemon(view) == ekans);
+
+    printf("       --> Checking that the view stays put at its end and start\n");
+    view_next_pokemon(view);
+    assert(view_current_pokemon(view) == ekans);
+    view_prev_pokemon(view);
+    view_prev_pokemon(view);
+    view_prev_pokemon(view);
+    assert(view_current_pokemon(view) == rattata);
+
+    printf("       --> Checking that the Pokedex's selected Pokemon has not moved\n");
+    assert(get_current_pokemon(pokedex) == ekans);
+    destroy_view(view);
+
+    printf("    ... Viewing all found Pokemon\n");
+    view = view_found_pokemon(pokedex);
+
+    printf("       --> Checking that they are in order of pokemon_id\n");
+    assert(view_count(view) == 3);
+    assert(view_current_pokemon(view) == bulbasaur);
+    view_next_pokemon(view);
+    assert(view_current_pokemon(view) == rattata);
+    view_next_pokemon(view);
+    assert(view_current_pokemon(view) == ekans);
+    destroy_view(view);
+
+    printf("    ... Viewing all found Pokemon with 'abcd' in the name\n");
+    view = view_search_pokemon(pokedex, "abcd");
+
+    printf("       --> Checking that the view is empty\n");
+    assert(view_count(view) == 0);
+    destroy_view(view);
+
+    printf("    ... Materializing a view of found Pokemon with 'a' in the name\n");
+    view = view_search_pokemon(pokedex, "a");
+    Pokedex view_pokedex = materialize_view(view);
+    Pokedex search_pokedex = search_pokemon(pokedex, "a");
+
+    printf("       --> Checking that it matches search_pokemon\n");
+    assert(count_total_pokemon(view_pokedex) == 3);
+    assert(count_found_pokemon(view_pokedex) == 3);
+    assert(count_total_pokemon(search_pokedex) == 3);
+    int i = 0;
+    while (i < 3) {
+        assert(is_copied_pokemon(get_current_pokemon(view_pokedex),
+            view_current_pokemon(view)));
+        assert(is_copied_pokemon(get_current_pokemon(search_pokedex),
+            view_current_pokemon(view)));
+        next_pokemon(view_pokedex);
+        next_pokemon(search_pokedex);
+        view_next_pokemon(view);
+        i += 1;
+    }
+
+    printf("    ... Destroying the view and all three Pokedexes\n");
+    destroy_view(view);
+    destroy_pokedex(view_pokedex);
     destroy_pokedex(search_pokedex);
+    destroy_pokedex(pokedex);
 
-    printf(">> Passed search_pokemon tests!\n");
+    printf(">> Passed Pokedex view tests!\n");
+}
+
+// `test_exploring_modes` checks whether both of go_exploring's modes
+// work correctly.
+//
+// In EXPLORE_COMPATIBLE mode, which a new Pokedex starts in, it replays
+// srand(seed) and rand() % factor itself, and checks that exactly the
+// Pokemon whose IDs that sequence reaches first are found.
+//
+// In EXPLORE_SAMPLED mode it checks that two Pokedexes holding the same
+// Pokemon find the same Pokemon for the same seed, and that asking for
+// every Pokemon in range finds them all.
+static void test_exploring_modes(void) {
+    printf("\n>> Testing set_exploring_mode\n");
+
+    int ids[] = {
+        BULBASAUR_ID, IVYSAUR_ID, VENUSAUR_ID, RATTATA_ID, RATICATE_ID,
+        EKANS_ID, ARBOK_ID, KOFFING_ID, WEEZING_ID
+    };
+    int n_ids = sizeof(ids) / sizeof(ids[0]);
+
+    printf("    ... Creating a Pokedex of nine Pokemon, leaving it in\n");
+    printf("    ... EXPLORE_COMPATIBLE mode\n");
+    Pokedex pokedex = create_nine_pokemon_pokedex();
+
+    printf("    ... Going exploring for four Pokemon using factor '999' and a seed '2'\n");
+    go_exploring(pokedex, 2, 999, 4);
+
+    printf("       --> Checking that the first four IDs rand() reaches are found\n");
+    int expected[9] = {0};
+    srand(2);
+    int n_expected = 0;
+    while (n_expected < 4) {
+        int search_id = rand() % 999;
+        int i = 0;
+        while (i < n_ids) {
+            if (ids[i] == search_id && expected[i] == 0) {
+                expected[i] = 1;
+                n_expected += 1;
+            }
+            i += 1;
+        }
+    }
+    assert(count_found_pokemon(pokedex) == 4);
+    Pokedex found_pokedex = get_found_pokemon(pokedex);
+    int i = 0;
+    while (i < n_ids) {
+        if (expected[i]) {
+            assert(pokemon_id(get_current_pokemon(found_pokedex)) == ids[i]);
+            next_pokemon(found_pokedex);
+        }
+        i += 1;
+    }
+    destroy_pokedex(found_pokedex);
+    destroy_pokedex(pokedex);
+
+    printf("    ... Creating two Pokedexes of nine Pokemon in EXPLORE_SAMPLED mode\n");
+    Pokedex first = create_nine_pokemon_pokedex();
+    Pokedex second = create_nine_pokemon_pokedex();
+    set_exploring_mode(first, EXPLORE_SAMPLED);
+    set_exploring_mode(second, EXPLORE_SAMPLED);
+
+    printf("    ... Going exploring in both for five Pokemon using factor '999'\n");
+    printf("    ... and a seed '7'\n");
+    go_exploring(first, 7, 999, 5);
+    go_exploring(second, 7, 999, 5);
+
+    printf("       --> Checking that both found the same five Pokemon\n");
+    assert(count_found_pokemon(first) == 5);
+    assert(count_found_pokemon(second) == 5);
+    Pokedex first_found = get_found_pokemon(first);
+    Pokedex second_found = get_found_pokemon(second);
+    i = 0;
+    while (i < 5) {
+        assert(pokemon_id(get_current_pokemon(first_found)) ==
+            pokemon_id(get_current_pokemon(second_found)));
+        next_pokemon(first_found);
+        next_pokemon(second_found);
+        i += 1;
+    }
+    destroy_pokedex(first_found);
+    destroy_pokedex(second_found);
+
+    printf("    ... Going exploring in the first for the last four Pokemon\n");
+    go_exploring(first, 1, 999, 4);
+
+    printf("       --> Checking that every Pokemon is now found\n");
+    assert(count_found_pokemon(first) == n_ids);
+
+    printf("    ... Destroying both Pokedexes\n");
+    destroy_pokedex(first);
+    destroy_pokedex(second);
+
+    printf(">> Passed set_exploring_mode tests!\n");
+}
+
+// `test_view_found_pokemon_in_range` checks whether the
+// view_found_pokemon_in_range function works correctly.
+//
+// It adds nine Pokemon, finds every one except Raticate (#020), and
+// checks that viewing IDs 2 to 23 gives Ivysaur, Venusaur, Rattata and
+// Ekans in order of pokemon_id.
+//
+// It then removes Rattata and checks that it has gone from the range,
+// and that an empty range and a range with no found Pokemon give empty
+// views.
+static void test_view_found_pokemon_in_range(void) {
+    printf("\n>> Testing view_found_pokemon_in_range\n");
+
+    printf("    ... Creating a Pokedex of nine Pokemon\n");
+    Pokedex pokedex = create_nine_pokemon_pokedex();
+
+    printf("    ... Setting every Pokemon except Raticate to be found\n");
+    int i = 0;
+    while (i < 9) {
+        if (pokemon_id(get_current_pokemon(pokedex)) != RATICATE_ID) {
+            find_current_pokemon(pokedex);
+        }
+        next_pokemon(pokedex);
+        i += 1;
+    }
+
+    printf("    ... Viewing the found Pokemon with IDs 2 to 23\n");
+    PokedexView view = view_found_pokemon_in_range(pokedex, 2, 23);
+
+    printf("       --> Checking that Ivysaur, Venusaur, Rattata and Ekans are in it\n");
+    int expected[] = {IVYSAUR_ID, VENUSAUR_ID, RATTATA_ID, EKANS_ID};
+    assert(view_count(view) == 4);
+    i = 0;
+    while (i < 4) {
+        assert(pokemon_id(view_current_pokemon(view)) == expected[i]);
+        view_next_pokemon(view);
+        i += 1;
+    }
+    destroy_view(view);
+
+    printf("    ... Removing Rattata\n");
+    change_current_pokemon(pokedex, RATTATA_ID);
+    remove_pokemon(pokedex);
+
+    printf("       --> Checking that Rattata is no longer in the range\n");
+    view = view_found_pokemon_in_range(pokedex, 2, 23);
+    assert(view_count(view) == 3);
+    view_next_pokemon(view);
+    view_next_pokemon(view);
+    assert(pokemon_id(view_current_pokemon(view)) == EKANS_ID);
+    destroy_view(view);
+
+    printf("       --> Checking that IDs 20 to 22 and 30 to 10 give empty views\n");
+    view = view_found_pokemon_in_range(pokedex, 20, 22);
+    assert(view_count(view) == 0);
+    destroy_view(view);
+    view = view_found_pokemon_in_range(pokedex, 30, 10);
+    assert(view_count(view) == 0);
+    destroy_view(view);
+
+    printf("    ... Destroying the Pokedex\n");
+    destroy_pokedex(pokedex);
+
+    printf(">> Passed view_found_pokemon_in_range tests!\n");
+}
+
+// `test_save_and_load_pokedex` checks whether the save_pokedex and
+// load_pokedex functions work correctly.
+//
+// It saves a Pokedex of nine Pokemon with Bulbasaur, Ivysaur and Ekans
+// found, Bulbasaur evolving into Ivysaur and Ekans selected, and checks
+// that loading it gives the same Pokemon in the same order, with the
+// same found Pokemon, evolution and selected Pokemon.
+//
+// It then checks that a save which cannot be written (because a
+// directory is in the way of its temporary file) leaves the old
+// snapshot loadable, and that load_pokedex returns NULL for a file that
+// does not exist and for a snapshot with one byte changed.
+static void test_save_and_load_pokedex(void) {
+    printf("\n>> Testing save_pokedex and load_pokedex\n");
+    char *path = "test_pokedex_snapshot.bin";
+
+    printf("    ... Creating a Pokedex of nine Pokemon\n");
+    Pokedex pokedex = create_nine_pokemon_pokedex();
+
+    printf("    ... Finding Bulbasaur, Ivysaur and Ekans\n");
+    find_current_pokemon(pokedex);
+    next_pokemon(pokedex);
+    find_current_pokemon(pokedex);
+    change_current_pokemon(pokedex, EKANS_ID);
+    find_current_pokemon(pokedex);
+
+    printf("    ... Adding an evolution from Bulbasaur to Ivysaur\n");
+    add_pokemon_evolution(pokedex, BULBASAUR_ID, IVYSAUR_ID);
+
+    printf("    ... Saving the Pokedex to %s\n", path);
+    assert(save_pokedex(pokedex, path) == 1);
+
+    printf("    ... Loading the Pokedex back\n");
+    Pokedex loaded = load_pokedex(path);
+    assert(loaded != NULL);
+
+    printf("       --> Checking the counts and the selected Pokemon\n");
+    assert(count_total_pokemon(loaded) == 9);
+    assert(count_found_pokemon(loaded) == 3);
+    assert(pokemon_id(get_current_pokemon(loaded)) == EKANS_ID);
+
+    printf("       --> Checking that every Pokemon was copied in order\n");
+    change_current_pokemon(pokedex, BULBASAUR_ID);
+    change_current_pokemon(loaded, BULBASAUR_ID);
+    int i = 0;
+    while (i < 9) {
+        assert(is_copied_pokemon(get_current_pokemon(loaded),
+            get_current_pokemon(pokedex)));
+        next_pokemon(pokedex);
+        next_pokemon(loaded);
+        i += 1;
+    }
+
+    printf("       --> Checking the found Pokemon and the evolution\n");
+    Pokedex found_pokedex = get_found_pokemon(loaded);
+    assert(pokemon_id(found_pokedex->head->pokemon) == BULBASAUR_ID);
+    assert(pokemon_id(found_pokedex->head->next->pokemon) == IVYSAUR_ID);
+    assert(pokemon_id(found_pokedex->tail->pokemon) == EKANS_ID);
+    destroy_pokedex(found_pokedex);
+    change_current_pokemon(loaded, BULBASAUR_ID);
+    assert(get_next_evolution(loaded) == IVYSAUR_ID);
+    next_pokemon(loaded);
+    assert(get_next_evolution(loaded) == DOES_NOT_EVOLVE);
+    destroy_pokedex(loaded);
+
+    printf("       --> Checking that a failed save keeps the old snapshot\n");
+    assert(mkdir("test_pokedex_snapshot.bin.tmp", 0700) == 0);
+    remove_pokemon(pokedex);
+    assert(save_pokedex(pokedex, path) == 0);
+    remove("test_pokedex_snapshot.bin.tmp");
+    loaded = load_pokedex(path);
+    assert(loaded != NULL);
+    assert(count_total_pokemon(loaded) == 9);
+    destroy_pokedex(loaded);
+
+    printf("       --> Checking that a missing file is not loaded\n");
+    assert(load_pokedex("no_such_snapshot.bin") == NULL);
+
+    printf("       --> Checking that a changed snapshot is not loaded\n");
+    FILE *file = fopen(path, "r+b");
+    assert(file != NULL);
+    fseek(file, -3, SEEK_END);
+    int byte = fgetc(file);
+    fseek(file, -3, SEEK_END);
+    fputc(byte ^ 1, file);
+    fclose(file);
+    assert(load_pokedex(path) == NULL);
+
+    printf("    ... Removing %s and destroying the Pokedex\n", path);
+    remove(path);
+    destroy_pokedex(pokedex);
+
+    printf(">> Passed save_pokedex and load_pokedex tests!\n");
+}
+
+// `test_import_pokedex` checks whether the import_pokedex function
+// works correctly.
+//
+// It imports a CSV file with a header, a quoted name, a blank line, a
+// Windows line ending, "None" and empty second types and an evolution,
+// and checks that the Pokemon are the same as the ones created by the
+// other tests, in the same order, with the evolution added. It then
+// imports the same Pokemon from a TSV file using two threads.
+//
+// It then checks that import_pokedex returns NULL for a file that does
+// not exist, a file with a repeated pokemon_id, a file with an unknown
+// type and a file with an evolution to a Pokemon not in the file.
+static void test_import_pokedex(void) {
+    printf("\n>> Testing import_pokedex\n");
+    char *path = "test_pokedex_import.csv";
+
+    printf("    ... Importing Bulbasaur, Ivysaur and Rattata from %s\n", path);
+    write_test_file(path,
+        "pokemon_id,name,height,weight,type1,type2,evolution_id\n"
+        "1,\"Bulbasaur\",0.7,6.9,Grass,Poison,2\r\n"
+        "\n"
+        "2,Ivysaur,1.0,13.0,grass,POISON,\n"
+        "19,Rattata,0.3,3.5,Normal,None\n");
+    Pokedex pokedex = import_pokedex(path, 1);
+    assert(pokedex != NULL);
+
+    printf("       --> Checking the counts and the Pokemon\n");
+    assert(count_total_pokemon(pokedex) == 3);
+    assert(count_found_pokemon(pokedex) == 0);
+    Pokemon bulbasaur = create_bulbasaur();
+    Pokemon ivysaur = create_ivysaur();
+    Pokemon rattata = create_rattata();
+    assert(is_copied_pokemon(get_current_pokemon(pokedex), bulbasaur));
+    next_pokemon(pokedex);
+    assert(is_copied_pokemon(get_current_pokemon(pokedex), ivysaur));
+    next_pokemon(pokedex);
+    assert(is_copied_pokemon(get_current_pokemon(pokedex), rattata));
+
+    printf("       --> Checking the evolution from Bulbasaur to Ivysaur\n");
+    change_current_pokemon(pokedex, BULBASAUR_ID);
+    assert(get_next_evolution(pokedex) == IVYSAUR_ID);
+    next_pokemon(pokedex);
+    assert(get_next_evolution(pokedex) == DOES_NOT_EVOLVE);
+    destroy_pokedex(pokedex);
+
+    printf("    ... Importing the same Pokemon from a TSV file with two threads\n");
+    write_test_file(path,
+        "1\tBulbasaur\t0.7\t6.9\tGrass\tPoison\t2\n"
+        "2\tIvysaur\t1.0\t13.0\tGrass\tPoison\n"
+        "19\tRattata\t0.3\t3.5\tNormal\t\t");
+    pokedex = import_pokedex(path, 2);
+    assert(pokedex != NULL);
+    assert(count_total_pokemon(pokedex) == 3);
+    assert(is_copied_pokemon(get_current_pokemon(pokedex), bulbasaur));
+    assert(get_next_evolution(pokedex) == IVYSAUR_ID);
+    change_current_pokemon(pokedex, RATTATA_ID);
+    assert(is_copied_pokemon(get_current_pokemon(pokedex), rattata));
+    destroy_pokedex(pokedex);
+    destroy_pokemon(bulbasaur);
+    destroy_pokemon(ivysaur);
+    destroy_pokemon(rattata);
+
+    printf("       --> Checking that a missing file is not imported\n");
+    assert(import_pokedex("no_such_file.csv", 1) == NULL);
+
+    printf("       --> Checking that a repeated pokemon_id is not imported\n");
+    write_test_file(path,
+        "1,Bulbasaur,0.7,6.9,Grass,Poison\n"
+        "1,Ivysaur,1.0,13.0,Grass,Poison\n");
+    assert(import_pokedex(path, 1) == NULL);
+
+    printf("       --> Checking that an unknown type is not imported\n");
+    write_test_file(path, "1,Bulbasaur,0.7,6.9,Grass,Leaf\n");
+    assert(import_pokedex(path, 1) == NULL);
+
+    printf("       --> Checking that an evolution to a missing Pokemon is not imported\n");
+    write_test_file(path, "1,Bulbasaur,0.7,6.9,Grass,Poison,2\n");
+    assert(import_pokedex(path, 1) == NULL);
+
+    printf("       --> Checking that evolutions forming a cycle are not imported\n");
+    write_test_file(path,
+        "1,Bulbasaur,0.7,6.9,Grass,Poison,2\n"
+        "2,Ivysaur,1.0,13.0,Grass,Poison,3\n"
+        "3,Venusaur,2.0,100.0,Grass,Poison,1\n");
+    assert(import_pokedex(path, 1) == NULL);
+
+    printf("    ... Removing %s\n", path);
+    remove(path);
+
+    printf(">> Passed import_pokedex tests!\n");
+}
+
+// `test_pokemon_type_from_string` checks whether pokemon_type_from_string
+// finds every type from its name in any case, and returns INVALID_TYPE
+// for strings that are not type names.
+//
+// The strings that are not type names include ones that share a length
+// and first two letters with a type, which pokemon_type_from_string
+// looks types up by, and ones that are a type name with letters added
+// or removed at the end.
+static void test_pokemon_type_from_string(void) {
+    printf("\n>> Testing pokemon_type_from_string\n");
+
+    printf("    ... Looking up every type by its name\n");
+    pokemon_type type = NONE_TYPE;
+    while (type < MAX_TYPE) {
+        assert(pokemon_type_from_string((char *) pokemon_type_to_string(type))
+            == type);
+        type += 1;
+    }
+
+    printf("       --> Checking that case is ignored\n");
+    assert(pokemon_type_from_string("fire") == FIRE_TYPE);
+    assert(pokemon_type_from_string("GHOST") == GHOST_TYPE);
+    assert(pokemon_type_from_string("eLeCtRiC") == ELECTRIC_TYPE);
+    assert(pokemon_type_from_string("none") == NONE_TYPE);
+
+    printf("       --> Checking that other strings are not types\n");
+    assert(pokemon_type_from_string("") == INVALID_TYPE);
+    assert(pokemon_type_from_string("Fir") == INVALID_TYPE);
+    assert(pokemon_type_from_string("Fires") == INVALID_TYPE);
+    assert(pokemon_type_from_string("Firf") == INVALID_TYPE);
+    assert(pokemon_type_from_string("Grasp") == INVALID_TYPE);
+    assert(pokemon_type_from_string("Electrical") == INVALID_TYPE);
+    assert(pokemon_type_from_string("F1re") == INVALID_TYPE);
+    assert(pokemon_type_from_string("Ice ") == INVALID_TYPE);
+
+    printf(">> Passed pokemon_type_from_string tests!\n");
+}
+
+// `test_interned_names` checks whether the names of Pokemon made with
+// new_pokedex_pokemon are shared rather than copied.
+//
+// It makes two Pokemon with the same long name in a Pokedex and checks
+// that their names are the same string, then checks that the clones
+// made by get_pokemon_of_type share that string, and that the clones
+// keep it after the original Pokedex is destroyed.
+static void test_interned_names(void) {
+    printf("\n>> Testing interned names\n");
+    char *long_name = "Mega Charizard X";
+
+    printf("    ... Creating two Pokemon named %s\n", long_name);
+    Pokedex pokedex = new_pokedex();
+    add_pokemon(pokedex, new_pokedex_pokemon(pokedex, 6, long_name, 1.7,
+        110.5, FIRE_TYPE, DRAGON_TYPE));
+    add_pokemon(pokedex, new_pokedex_pokemon(pokedex, 10034, long_name, 1.7,
+        110.5, FIRE_TYPE, DRAGON_TYPE));
+    add_pokemon(pokedex, create_bulbasaur());
+
+    printf("       --> Checking that they share one name\n");
+    char *first_name = pokemon_name(pokedex->head->pokemon);
+    assert(strcmp(first_name, long_name) == 0);
+    assert(pokemon_name(pokedex->head->next->pokemon) == first_name);
+
+    printf("    ... Finding every Pokemon and getting the Fire type Pokemon\n");
+    find_current_pokemon(pokedex);
+    next_pokemon(pokedex);
+    find_current_pokemon(pokedex);
+    next_pokemon(pokedex);
+    find_current_pokemon(pokedex);
+    Pokedex fire_pokedex = get_pokemon_of_type(pokedex, FIRE_TYPE);
+    assert(count_total_pokemon(fire_pokedex) == 2);
+
+    printf("       --> Checking that the clones share the name too\n");
+    assert(is_copied_pokemon(fire_pokedex->head->pokemon, pokedex->head->pokemon));
+    assert(pokemon_name(fire_pokedex->head->pokemon) == first_name);
+    assert(pokemon_name(fire_pokedex->tail->pokemon) == first_name);
+
+    printf("    ... Destroying the original Pokedex\n");
+    destroy_pokedex(pokedex);
+
+    printf("       --> Checking that the clones still have the name\n");
+    assert(strcmp(pokemon_name(fire_pokedex->head->pokemon), long_name) == 0);
+    assert(strcmp(pokemon_name(fire_pokedex->tail->pokemon), long_name) == 0);
+    destroy_pokedex(fire_pokedex);
+
+    printf(">> Passed interned names tests!\n");
+}
+
+// `test_shared_clones` checks whether clone_pokemon shares the original
+// Pokemon's attributes, and whether destroy_pokemon only frees them
+// once the original and all of its clones are destroyed.
+//
+// It clones a malloced Pokemon, and clones the clone, checking that all
+// three have the same name string. It then destroys the original before
+// the clones and checks that the clones still have their attributes.
+//
+// It also checks that a clone of a Pokemon from an arena Pokedex has a
+// copy of the attributes, which it keeps after the Pokedex (and so the
+// arena) is destroyed.
+static void test_shared_clones(void) {
+    printf("\n>> Testing shared clones\n");
+
+    printf("    ... Cloning Bulbasaur, and then cloning the clone\n");
+    Pokemon bulbasaur = create_bulbasaur();
+    Pokemon clone = clone_pokemon(bulbasaur);
+    Pokemon clone_of_clone = clone_pokemon(clone);
+
+    printf("       --> Checking that the clones share Bulbasaur's name\n");
+    assert(is_copied_pokemon(clone, bulbasaur));
+    assert(is_copied_pokemon(clone_of_clone, bulbasaur));
+    assert(pokemon_name(clone) == pokemon_name(bulbasaur));
+    assert(pokemon_name(clone_of_clone) == pokemon_name(bulbasaur));
+
+    printf("    ... Destroying Bulbasaur before its clones\n");
+    destroy_pokemon(bulbasaur);
+
+    printf("       --> Checking that the clones are unchanged\n");
+    assert(pokemon_id(clone) == BULBASAUR_ID);
+    assert(strcmp(pokemon_name(clone), BULBASAUR_NAME) == 0);
+    assert(pokemon_height(clone_of_clone) == BULBASAUR_HEIGHT);
+    assert(pokemon_second_type(clone_of_clone) == BULBASAUR_SECOND_TYPE);
+    destroy_pokemon(clone);
+    assert(strcmp(pokemon_name(clone_of_clone), BULBASAUR_NAME) == 0);
+    destroy_pokemon(clone_of_clone);
+
+    printf("    ... Cloning Bulbasaur from an arena Pokedex\n");
+    Pokedex pokedex = new_arena_pokedex();
+    add_pokemon(pokedex, new_pokedex_pokemon(pokedex, BULBASAUR_ID,
+        BULBASAUR_NAME, BULBASAUR_HEIGHT, BULBASAUR_WEIGHT,
+        BULBASAUR_FIRST_TYPE, BULBASAUR_SECOND_TYPE));
+    Pokemon arena_clone = clone_pokemon(get_current_pokemon(pokedex));
+    assert(is_copied_pokemon(arena_clone, get_current_pokemon(pokedex)));
+    assert(pokemon_name(arena_clone) != pokemon_name(get_current_pokemon(pokedex)));
+
+    printf("    ... Destroying the arena Pokedex\n");
+    destroy_pokedex(pokedex);
+
+    printf("       --> Checking that the clone is unchanged\n");
+    assert(pokemon_id(arena_clone) == BULBASAUR_ID);
+    assert(strcmp(pokemon_name(arena_clone), BULBASAUR_NAME) == 0);
+    assert(pokemon_arena(arena_clone) == NULL);
+    destroy_pokemon(arena_clone);
+
+    printf(">> Passed shared clones tests!\n");
+}
+
+// `test_pack_pokedex` checks whether pack_pokemon, unpack_pokemon,
+// pack_pokedex and unpack_pokedex work correctly.
+//
+// It packs a Pokedex of nine Pokemon, checks that the records read the
+// same as the Pokemon, and that unpacking them gives Pokemon with
+// exactly the same attributes in the same order.
+//
+// It then checks that Pokemon which do not fit in a record (a long
+// name, a height that is not a whole number of tenths, a weight that is
+// too large) are not packed, and that pack_pokedex returns -1 for a
+// Pokedex holding one of them.
+static void test_pack_pokedex(void) {
+    printf("\n>> Testing pack_pokedex and unpack_pokedex\n");
+
+    printf("    ... Packing a Pokedex of nine Pokemon\n");
+    Pokedex pokedex = create_nine_pokemon_pokedex();
+    CompactPokemon *records = NULL;
+    assert(pack_pokedex(pokedex, &records) == 9);
+
+    printf("       --> Checking the records\n");
+    assert(records[0].pokemon_id == BULBASAUR_ID);
+    assert(strcmp(records[0].name, BULBASAUR_NAME) == 0);
+    assert(compact_pokemon_height(&records[0]) == BULBASAUR_HEIGHT);
+    assert(compact_pokemon_weight(&records[0]) == BULBASAUR_WEIGHT);
+    assert(compact_pokemon_first_type(&records[0]) == BULBASAUR_FIRST_TYPE);
+    assert(compact_pokemon_second_type(&records[0]) == BULBASAUR_SECOND_TYPE);
+    assert(records[8].pokemon_id == WEEZING_ID);
+
+    printf("    ... Unpacking the records into a new Pokedex\n");
+    Pokedex unpacked = unpack_pokedex(records, 9);
+    assert(count_total_pokemon(unpacked) == 9);
+    assert(count_found_pokemon(unpacked) == 0);
+
+    printf("       --> Checking that every Pokemon is the same, in order\n");
+    int i = 0;
+    while (i < 9) {
+        assert(is_copied_pokemon(get_current_pokemon(unpacked),
+            get_current_pokemon(pokedex)));
+        assert(strcmp(pokemon_name(get_current_pokemon(unpacked)),
+            pokemon_name(get_current_pokemon(pokedex))) == 0);
+        next_pokemon(pokedex);
+        next_pokemon(unpacked);
+        i += 1;
+    }
+    destroy_pokedex(unpacked);
+
+    printf("       --> Checking that one record unpacks to the same Pokemon\n");
+    Pokemon venusaur = unpack_pokemon(&records[2]);
+    Pokemon original = create_venusaur();
+    assert(is_copied_pokemon(venusaur, original));
+    destroy_pokemon(venusaur);
+    destroy_pokemon(original);
+    free(records);
+
+    printf("       --> Checking that Pokemon which do not fit are not packed\n");
+    CompactPokemon record;
+    Pokemon long_name = new_pokemon(1, "A Very Long Pokemon Name", 1.0, 1.0,
+        NORMAL_TYPE, NONE_TYPE);
+    assert(pack_pokemon(long_name, &record) == 0);
+    Pokemon fine_height = new_pokemon(2, "Fine", 1.05, 1.0, NORMAL_TYPE,
+        NONE_TYPE);
+    assert(pack_pokemon(fine_height, &record) == 0);
+    Pokemon heavy = new_pokemon(151, "Heavy", 1.0, 7000.0, NORMAL_TYPE,
+        NONE_TYPE);
+    assert(pack_pokemon(heavy, &record) == 0);
+    destroy_pokemon(long_name);
+    destroy_pokemon(fine_height);
+
+    printf("       --> Checking that a Pokedex with one of them is not packed\n");
+    add_pokemon(pokedex, heavy);
+    assert(pack_pokedex(pokedex, &records) == -1);
+    assert(records == NULL);
+
+    printf("    ... Destroying the Pokedex\n");
+    destroy_pokedex(pokedex);
+
+    printf(">> Passed pack_pokedex and unpack_pokedex tests!\n");
+}
+
+// `test_concurrent_pokedex` checks whether new_concurrent_pokedex works
+// correctly.
+//
+// It adds Bulbasaur, Ivysaur and Venusaur to a concurrent Pokedex and
+// finds them, checking that it behaves like any other Pokedex.
+//
+// It then starts four threads at once: one adds 200 Pokemon and then
+// removes them all again (enough to compact the Pokedex), one adds 50
+// Pokemon and keeps them, and two keep searching for and counting
+// Pokemon, which should always see the three found Pokemon and never
+// fewer Pokemon than at the start. Once they finish, the Pokedex should
+// hold the three Pokemon and the 50 that were kept.
+static void test_concurrent_pokedex(void) {
+    printf("\n>> Testing new_concurrent_pokedex\n");
+
+    printf("    ... Creating a concurrent Pokedex\n");
+    Pokedex pokedex = new_concurrent_pokedex();
+    assert(count_total_pokemon(pokedex) == 0);
+
+    printf("    ... Adding and finding Bulbasaur, Ivysaur and Venusaur\n");
+    add_pokemon(pokedex, create_bulbasaur());
+    add_pokemon(pokedex, create_ivysaur());
+    add_pokemon(pokedex, create_venusaur());
+    add_pokemon_evolution(pokedex, BULBASAUR_ID, IVYSAUR_ID);
+    int i = 0;
+    while (i < 3) {
+        find_current_pokemon(pokedex);
+        next_pokemon(pokedex);
+        i += 1;
+    }
+
+    printf("       --> Checking it behaves like a normal Pokedex\n");
+    assert(count_total_pokemon(pokedex) == 3);
+    assert(count_found_pokemon(pokedex) == 3);
+    assert(pokemon_id(get_current_pokemon(pokedex)) == VENUSAUR_ID);
+    change_current_pokemon(pokedex, BULBASAUR_ID);
+    assert(get_next_evolution(pokedex) == IVYSAUR_ID);
+    Pokedex found = search_pokemon(pokedex, "SAUR");
+    assert(count_total_pokemon(found) == 3);
+    destroy_pokedex(found);
+
+    printf("    ... Adding, removing and reading Pokemon on four threads\n");
+    struct concurrent_test_thread threads[4];
+    pthread_t ids[4];
+    i = 0;
+    while (i < 4) {
+        threads[i].pokedex = pokedex;
+        threads[i].first_id = 1000 + i * 1000;
+        threads[i].n_pokemon = 200;
+        threads[i].remove = (i == 0);
+        threads[i].reader = (i >= 2);
+        if (i == 1) {
+            threads[i].n_pokemon = 50;
+        }
+        int created = pthread_create(&ids[i], NULL, use_concurrently,
+            &threads[i]);
+        assert(created == 0);
+        i += 1;
+    }
+    i = 0;
+    while (i < 4) {
+        pthread_join(ids[i], NULL);
+        i += 1;
+    }
+
+    printf("       --> Checking the kept Pokemon are all there\n");
+    assert(count_total_pokemon(pokedex) == 3 + 50);
+    assert(count_found_pokemon(pokedex) == 3);
+    change_current_pokemon(pokedex, threads[1].first_id);
+    i = 0;
+    while (i < 50) {
+        assert(pokemon_id(get_current_pokemon(pokedex)) ==
+            threads[1].first_id + i);
+        next_pokemon(pokedex);
+        i += 1;
+    }
+    found = search_pokemon(pokedex, "saur");
+    assert(count_total_pokemon(found) == 3);
+    destroy_pokedex(found);
+
+    printf("    ... Destroying the Pokedex\n");
+    destroy_pokedex(pokedex);
+
+    printf(">> Passed new_concurrent_pokedex tests!\n");
+}
+
+// `test_pokedex_cursors` checks whether the PokedexCursor functions
+// work correctly.
+//
+// It makes two cursors on an empty Pokedex, then adds nine Pokemon and
+// checks that both cursors select the first one. It moves the cursors
+// separately, checking that neither they nor the Pokedex's currently
+// selected Pokemon move each other, and that finding Pokemon and their
+// evolutions through a cursor work.
+//
+// It then removes the Pokemon a cursor selects, and the last Pokemon,
+// checking that cursors on them move to the next (or previous) Pokemon
+// and that other cursors stay put.
+static void test_pokedex_cursors(void) {
+    printf("\n>> Testing PokedexCursor functions\n");
+
+    printf("    ... Creating two cursors on an empty Pokedex\n");
+    Pokedex pokedex = new_pokedex();
+    PokedexCursor first = new_pokedex_cursor(pokedex);
+    PokedexCursor second = new_pokedex_cursor(pokedex);
+
+    printf("    ... Adding nine Pokemon\n");
+    add_pokemon(pokedex, create_bulbasaur());
+    add_pokemon(pokedex, create_ivysaur());
+    add_pokemon(pokedex, create_venusaur());
+    add_pokemon(pokedex, create_rattata());
+    add_pokemon(pokedex, create_raticate());
+    add_pokemon(pokedex, create_ekans());
+    add_pokemon(pokedex, create_arbok());
+    add_pokemon(pokedex, create_koffing());
+    add_pokemon(pokedex, create_weezing());
+    add_pokemon_evolution(pokedex, RATTATA_ID, RATICATE_ID);
+
+    printf("       --> Checking both cursors select Bulbasaur\n");
+    assert(pokemon_id(cursor_current_pokemon(first)) == BULBASAUR_ID);
+    assert(pokemon_id(cursor_current_pokemon(second)) == BULBASAUR_ID);
+
+    printf("    ... Moving the cursors separately\n");
+    cursor_next_pokemon(first);
+    cursor_next_pokemon(first);
+    cursor_change_pokemon(second, WEEZING_ID);
+    cursor_next_pokemon(second);
+    cursor_change_pokemon(second, 151);
+
+    printf("       --> Checking the cursors and the Pokedex are unchanged by each other\n");
+    assert(pokemon_id(cursor_current_pokemon(first)) == VENUSAUR_ID);
+    assert(pokemon_id(cursor_current_pokemon(second)) == WEEZING_ID);
+    assert(pokemon_id(get_current_pokemon(pokedex)) == BULBASAUR_ID);
+    cursor_prev_pokemon(first);
+    assert(pokemon_id(cursor_current_pokemon(first)) == IVYSAUR_ID);
+    assert(pokemon_id(cursor_current_pokemon(second)) == WEEZING_ID);
+
+    printf("    ... Finding Rattata through a cursor\n");
+    cursor_change_pokemon(first, RATTATA_ID);
+    cursor_find_pokemon(first);
+
+    printf("       --> Checking Rattata is found and evolves into Raticate\n");
+    assert(count_found_pokemon(pokedex) == 1);
+    change_current_pokemon(pokedex, RATTATA_ID);
+    assert(is_same_pokemon(get_current_pokemon(pokedex),
+        cursor_current_pokemon(first)));
+    assert(cursor_next_evolution(first) == RATICATE_ID);
+    assert(cursor_next_evolution(second) == DOES_NOT_EVOLVE);
+
+    printf("    ... Removing Rattata and then Weezing\n");
+    remove_pokemon(pokedex);
+    change_current_pokemon(pokedex, WEEZING_ID);
+    remove_pokemon(pokedex);
+
+    printf("       --> Checking the cursors moved off them\n");
+    assert(pokemon_id(cursor_current_pokemon(first)) == RATICATE_ID);
+    assert(pokemon_id(cursor_current_pokemon(second)) == KOFFING_ID);
+    assert(pokemon_id(get_current_pokemon(pokedex)) == KOFFING_ID);
+
+    printf("    ... Destroying the cursors and the Pokedex\n");
+    destroy_pokedex_cursor(first);
+    destroy_pokedex_cursor(second);
+    destroy_pokedex(pokedex);
+
+    printf(">> Passed PokedexCursor functions tests!\n");
+}
+
+// `test_sharded_pokedex` checks whether the ShardedPokedex functions
+// work correctly.
+//
+// It adds the nine Pokemon to a Pokedex of four shards in an order
+// that is not their pokemon_id order, finds some of them by
+// pokemon_id, and checks the counts and that the get_ and search_
+// functions return found copies from every shard in order of
+// pokemon_id.
+//
+// It then removes Pokemon by pokemon_id, checking that missing Pokemon
+// can be neither found nor removed, and has four threads add 100
+// Pokemon each at once, checking that all of them are there.
+static void test_sharded_pokedex(void) {
+    printf("\n>> Testing ShardedPokedex functions\n");
+
+    printf("    ... Adding nine Pokemon to a Pokedex of four shards\n");
+    ShardedPokedex sharded = new_sharded_pokedex(4);
+    sharded_add_pokemon(sharded, create_weezing());
+    sharded_add_pokemon(sharded, create_koffing());
+    sharded_add_pokemon(sharded, create_arbok());
+    sharded_add_pokemon(sharded, create_ekans());
+    sharded_add_pokemon(sharded, create_raticate());
+    sharded_add_pokemon(sharded, create_rattata());
+    sharded_add_pokemon(sharded, create_venusaur());
+    sharded_add_pokemon(sharded, create_ivysaur());
+    sharded_add_pokemon(sharded, create_bulbasaur());
+    assert(sharded_count_total_pokemon(sharded) == 9);
+    assert(sharded_count_found_pokemon(sharded) == 0);
+
+    printf("    ... Finding Weezing, Ekans, Venusaur and Bulbasaur\n");
+    assert(sharded_find_pokemon(sharded, WEEZING_ID) == 1);
+    assert(sharded_find_pokemon(sharded, EKANS_ID) == 1);
+    assert(sharded_find_pokemon(sharded, VENUSAUR_ID) == 1);
+    assert(sharded_find_pokemon(sharded, BULBASAUR_ID) == 1);
+    assert(sharded_find_pokemon(sharded, 151) == 0);
+    assert(sharded_count_found_pokemon(sharded) == 4);
+
+    printf("       --> Checking the poison type Pokemon in order\n");
+    Pokedex poison = sharded_get_pokemon_of_type(sharded, POISON_TYPE);
+    assert(count_total_pokemon(poison) == 4);
+    assert(count_found_pokemon(poison) == 4);
+    assert(pokemon_id(get_current_pokemon(poison)) == BULBASAUR_ID);
+    next_pokemon(poison);
+    assert(pokemon_id(get_current_pokemon(poison)) == VENUSAUR_ID);
+    next_pokemon(poison);
+    assert(pokemon_id(get_current_pokemon(poison)) == EKANS_ID);
+    next_pokemon(poison);
+    assert(pokemon_id(get_current_pokemon(poison)) == WEEZING_ID);
+    destroy_pokedex(poison);
+
+    printf("       --> Checking the other queries\n");
+    Pokedex results = sharded_get_pokemon_of_both_types(sharded, GRASS_TYPE,
+        POISON_TYPE);
+    assert(count_total_pokemon(results) == 2);
+    destroy_pokedex(results);
+    results = sharded_get_pokemon_of_either_type(sharded, GRASS_TYPE,
+        NORMAL_TYPE);
+    assert(count_total_pokemon(results) == 2);
+    destroy_pokedex(results);
+    results = sharded_get_found_pokemon(sharded);
+    assert(count_total_pokemon(results) == 4);
+    assert(pokemon_id(get_current_pokemon(results)) == BULBASAUR_ID);
+    destroy_pokedex(results);
+    results = sharded_search_pokemon(sharded, "SAUR");
+    assert(count_total_pokemon(results) == 2);
+    destroy_pokedex(results);
+
+    printf("    ... Removing Venusaur and Koffing\n");
+    assert(sharded_remove_pokemon(sharded, VENUSAUR_ID) == 1);
+    assert(sharded_remove_pokemon(sharded, KOFFING_ID) == 1);
+
+    printf("       --> Checking they can no longer be found or removed\n");
+    assert(sharded_remove_pokemon(sharded, VENUSAUR_ID) == 0);
+    assert(sharded_find_pokemon(sharded, KOFFING_ID) == 0);
+    assert(sharded_count_total_pokemon(sharded) == 7);
+    assert(sharded_count_found_pokemon(sharded) == 3);
+
+    printf("    ... Adding 100 Pokemon on each of four threads\n");
+    pthread_t ids[4];
+    int i = 0;
+    while (i < 4) {
+        int created = pthread_create(&ids[i], NULL, add_sharded_pokemon,
+            sharded);
+        assert(created == 0);
+        i += 1;
+    }
+    i = 0;
+    while (i < 4) {
+        pthread_join(ids[i], NULL);
+        i += 1;
+    }
+
+    printf("       --> Checking every one of them was added and found\n");
+    assert(sharded_count_total_pokemon(sharded) == 7 + 400);
+    assert(sharded_count_found_pokemon(sharded) == 3 + 400);
+    i = 0;
+    while (i < 400) {
+        assert(sharded_remove_pokemon(sharded, 1000 + i) == 1);
+        i += 1;
+    }
+    assert(sharded_count_total_pokemon(sharded) == 7);
+
+    printf("    ... Destroying the sharded Pokedex\n");
+    destroy_sharded_pokedex(sharded);
+
+    printf(">> Passed ShardedPokedex functions tests!\n");
+}
+
+// `test_concurrent_exploring` checks whether threads can find Pokemon
+// in a concurrent Pokedex at the same time.
+//
+// It adds 1200 Pokemon with IDs from 0 to a concurrent Pokedex in
+// EXPLORE_SAMPLED mode, then starts four threads at once. Each goes exploring four times for 50
+// Pokemon with pokemon_id below 1000, and uses a cursor to find every
+// Pokemon with pokemon_id from 1000, which the other threads are
+// finding too. Once they finish, exactly 800 + 200 Pokemon should be
+// found, each of them only once.
+static void test_concurrent_exploring(void) {
+    printf("\n>> Testing concurrent exploring\n");
+
+    printf("    ... Adding 1200 Pokemon to a concurrent Pokedex\n");
+    Pokedex pokedex = new_concurrent_pokedex();
+    set_exploring_mode(pokedex, EXPLORE_SAMPLED);
+    int i = 0;
+    while (i < 1200) {
+        char name[] = "Explored";
+        name[0] = 'A' + i % 26;
+        name[1] = 'a' + i / 26 % 26;
+        add_pokemon(pokedex, new_pokedex_pokemon(pokedex, i, name, 1.0, 1.0,
+            NORMAL_TYPE, NONE_TYPE));
+        i += 1;
+    }
+
+    printf("    ... Exploring and finding Pokemon on four threads\n");
+    pthread_t ids[4];
+    i = 0;
+    while (i < 4) {
+        int created = pthread_create(&ids[i], NULL, explore_concurrently,
+            pokedex);
+        assert(created == 0);
+        i += 1;
+    }
+    i = 0;
+    while (i < 4) {
+        pthread_join(ids[i], NULL);
+        i += 1;
+    }
+
+    printf("       --> Checking every Pokemon was found once\n");
+    assert(count_total_pokemon(pokedex) == 1200);
+    assert(count_found_pokemon(pokedex) == 1000);
+    Pokedex found = get_found_pokemon(pokedex);
+    assert(count_total_pokemon(found) == 1000);
+    int last_id = -1;
+    i = 0;
+    while (i < 1000) {
+        assert(pokemon_id(get_current_pokemon(found)) > last_id);
+        last_id = pokemon_id(get_current_pokemon(found));
+        next_pokemon(found);
+        i += 1;
+    }
+    destroy_pokedex(found);
+    found = get_pokemon_of_type(pokedex, NORMAL_TYPE);
+    assert(count_total_pokemon(found) == 1000);
+    destroy_pokedex(found);
+
+    printf("    ... Destroying the Pokedex\n");
+    destroy_pokedex(pokedex);
+
+    printf(">> Passed concurrent exploring tests!\n");
+}
+
+// `test_parallel_queries` checks whether Stage 5 queries split across
+// threads (see set_pool_threads) give the same results as on one.
+//
+// It adds 200000 Pokemon of mixed types and names to a Pokedex, enough
+// for queries to be split, and finds all but every seventh one. It then
+// views Pokemon of a type, of both and either of two types, and with
+// text in their name, on one thread and then on four, checking that
+// the same Pokemon come back in the same order. Finally it checks that
+// get_pokemon_of_type copies the same Pokemon on four threads.
+static void test_parallel_queries(void) {
+    printf("\n>> Testing set_pool_threads\n");
+
+    printf("    ... Adding and finding 200000 Pokemon\n");
+    Pokedex pokedex = new_pokedex();
+    int i = 0;
+    while (i < 200000) {
+        char name[] = "Parallel";
+        name[0] = 'A' + i % 26;
+        name[1] = 'a' + i / 26 % 26;
+        name[2] = 'a' + i / 676 % 26;
+        pokemon_type second = NONE_TYPE;
+        if (i % 3 == 0) {
+            second = FIRE_TYPE;
+        }
+        add_pokemon(pokedex, new_pokedex_pokemon(pokedex, i, name, 1.0, 1.0,
+            (pokemon_type) (WATER_TYPE + i % 5), second));
+        if (i % 7 != 0) {
+            find_current_pokemon(pokedex);
+        }
+        next_pokemon(pokedex);
+        i += 1;
+    }
+
+    printf("    ... Viewing Pokemon on one thread and on four\n");
+    PokedexView serial[4];
+    PokedexView parallel[4];
+    set_pool_threads(pokedex, 1);
+    serial[0] = view_pokemon_of_type(pokedex, WATER_TYPE);
+    serial[1] = view_pokemon_of_both_types(pokedex, WATER_TYPE, FIRE_TYPE);
+    serial[2] = view_pokemon_of_either_type(pokedex, GRASS_TYPE, FIRE_TYPE);
+    serial[3] = view_search_pokemon(pokedex, "LLE");
+    set_pool_threads(pokedex, 4);
+    parallel[0] = view_pokemon_of_type(pokedex, WATER_TYPE);
+    parallel[1] = view_pokemon_of_both_types(pokedex, WATER_TYPE, FIRE_TYPE);
+    parallel[2] = view_pokemon_of_either_type(pokedex, GRASS_TYPE, FIRE_TYPE);
+    parallel[3] = view_search_pokemon(pokedex, "LLE");
+
+    printf("       --> Checking the views hold the same Pokemon in order\n");
+    assert(view_count(serial[0]) > 0);
+    assert(view_count(serial[3]) > 0);
+    i = 0;
+    while (i < 4) {
+        assert(is_same_view(serial[i], parallel[i]));
+        destroy_view(serial[i]);
+        destroy_view(parallel[i]);
+        i += 1;
+    }
+
+    printf("    ... Copying Pokemon of a type on four threads\n");
+    PokedexView view = view_pokemon_of_type(pokedex, FIRE_TYPE);
+    Pokedex copies = get_pokemon_of_type(pokedex, FIRE_TYPE);
+
+    printf("       --> Checking the copies match the view\n");
+    assert(count_total_pokemon(copies) == view_count(view));
+    assert(count_found_pokemon(copies) == view_count(view));
+    i = 0;
+    while (i < view_count(view)) {
+        assert(is_copied_pokemon(get_current_pokemon(copies),
+            view_current_pokemon(view)));
+        next_pokemon(copies);
+        view_next_pokemon(view);
+        i += 1;
+    }
+    destroy_pokedex(copies);
+    destroy_view(view);
+
+    printf("    ... Destroying the Pokedex\n");
+    destroy_pokedex(pokedex);
+
+    printf(">> Passed set_pool_threads tests!\n");
+}
+
+// `test_task_pools` checks whether the TaskPool functions, and
+// set_task_pool, work correctly.
+//
+// It runs 100 chunks on a pool of four threads, each of which runs 10
+// chunks of its own on the same pool, and checks that every chunk ran
+// exactly once.
+//
+// It then makes two Pokedexes of 140000 Pokemon, enough for exploring
+// them to be split, one sharing the pool and one running on a single
+// thread. Exploring both with the same seeds should find the same
+// Pokemon. The pool should still work once the Pokedex sharing it has
+// been destroyed.
+//
+// Finally it checks that default_task_pool always returns the same
+// pool, and that chunks run on it exactly once too.
+static void test_task_pools(void) {
+    printf("\n>> Testing task pools\n");
+
+    printf("    ... Creating a task pool of four threads\n");
+    TaskPool pool = new_task_pool(4);
+    assert(task_pool_threads(pool) == 4);
+
+    printf("    ... Running 100 chunks that each run 10 more\n");
+    struct pool_test_counts *counts = calloc(1, sizeof *counts);
+    assert(counts != NULL);
+    counts->pool = pool;
+    task_pool_run(pool, 100, count_outer_chunk, counts);
+
+    printf("       --> Checking every chunk ran once\n");
+    int i = 0;
+    while (i < 100) {
+        assert(counts->outer[i] == 1);
+        int j = 0;
+        while (j < 10) {
+            assert(counts->nested[i][j] == 1);
+            j += 1;
+        }
+        i += 1;
+    }
+
+    printf("    ... Exploring a Pokedex sharing the pool and one without\n");
+    Pokedex shared = create_exploring_pokedex(140000);
+    set_task_pool(shared, pool);
+    Pokedex alone = create_exploring_pokedex(140000);
+    set_pool_threads(alone, 1);
+    i = 0;
+    while (i < 3) {
+        go_exploring(shared, 42 + i, 100000, 1000);
+        go_exploring(alone, 42 + i, 100000, 1000);
+        i += 1;
+    }
+
+    printf("       --> Checking they found the same Pokemon\n");
+    assert(count_found_pokemon(shared) == 3000);
+    assert(count_found_pokemon(alone) == 3000);
+    PokedexView shared_found = view_found_pokemon(shared);
+    PokedexView alone_found = view_found_pokemon(alone);
+    i = 0;
+    while (i < 3000) {
+        assert(pokemon_id(view_current_pokemon(shared_found)) ==
+            pokemon_id(view_current_pokemon(alone_found)));
+        view_next_pokemon(shared_found);
+        view_next_pokemon(alone_found);
+        i += 1;
+    }
+    destroy_view(shared_found);
+    destroy_view(alone_found);
+
+    printf("    ... Destroying the Pokedexes\n");
+    destroy_pokedex(shared);
+    destroy_pokedex(alone);
+
+    printf("       --> Checking the pool still runs chunks\n");
+    memset(counts, 0, sizeof *counts);
+    counts->pool = pool;
+    task_pool_run(pool, 100, count_outer_chunk, counts);
+    assert(counts->outer[99] == 1 && counts->nested[99][9] == 1);
+
+    printf("    ... Destroying the task pool\n");
+    destroy_task_pool(pool);
+
+    printf("       --> Checking default_task_pool returns one pool\n");
+    TaskPool default_pool = default_task_pool();
+    assert(default_pool == default_task_pool());
+    assert(task_pool_threads(default_pool) >= 1);
+
+    printf("    ... Running 100 chunks that each run 10 more on it\n");
+    memset(counts, 0, sizeof *counts);
+    counts->pool = default_pool;
+    task_pool_run(default_pool, 100, count_outer_chunk, counts);
+
+    printf("       --> Checking every chunk ran once\n");
+    i = 0;
+    while (i < 100) {
+        assert(counts->outer[i] == 1 && counts->nested[i][9] == 1);
+        i += 1;
+    }
+    free(counts);
+
+    printf(">> Passed task pool tests!\n");
+}
+
+// `test_evolution_graph` checks whether get_prev_evolution and
+// cursor_prev_evolution find the Pokemon that evolve into the selected
+// one, and whether the evolutions stay right as they change.
+//
+// Koffing and then Bulbasaur are made to evolve into Ivysaur, so the
+// first of them in Pokedex order, Bulbasaur, should be found, and then
+// Koffing once Bulbasaur evolves into Venusaur instead. Removing
+// Ivysaur should leave Koffing not evolving, and removing Bulbasaur
+// should leave no Pokemon evolving into Venusaur. The evolutions should
+// be the same after saving and loading the Pokedex.
+static void test_evolution_graph(void) {
+    printf("\n>> Testing evolution graphs\n");
+
+    printf("    ... Creating a Pokedex of nine Pokemon\n");
+    Pokedex pokedex = create_nine_pokemon_pokedex();
+
+    printf("       --> Checking no Pokemon evolves into Bulbasaur\n");
+    assert(get_prev_evolution(pokedex) == NO_PRE_EVOLUTION);
+
+    printf("    ... Adding evolutions from Koffing and Bulbasaur to Ivysaur\n");
+    add_pokemon_evolution(pokedex, KOFFING_ID, IVYSAUR_ID);
+    add_pokemon_evolution(pokedex, BULBASAUR_ID, IVYSAUR_ID);
+    add_pokemon_evolution(pokedex, IVYSAUR_ID, VENUSAUR_ID);
+
+    printf("       --> Checking Bulbasaur is found evolving into Ivysaur\n");
+    change_current_pokemon(pokedex, IVYSAUR_ID);
+    assert(get_prev_evolution(pokedex) == BULBASAUR_ID);
+    change_current_pokemon(pokedex, VENUSAUR_ID);
+    assert(get_prev_evolution(pokedex) == IVYSAUR_ID);
+
+    printf("    ... Making Bulbasaur evolve into Venusaur instead\n");
+    add_pokemon_evolution(pokedex, BULBASAUR_ID, VENUSAUR_ID);
+
+    printf("       --> Checking Koffing is found evolving into Ivysaur\n");
+    change_current_pokemon(pokedex, IVYSAUR_ID);
+    assert(get_prev_evolution(pokedex) == KOFFING_ID);
+    change_current_pokemon(pokedex, VENUSAUR_ID);
+    assert(get_prev_evolution(pokedex) == BULBASAUR_ID);
+
+    printf("    ... Creating a cursor on Ivysaur\n");
+    PokedexCursor cursor = new_pokedex_cursor(pokedex);
+    cursor_change_pokemon(cursor, IVYSAUR_ID);
+
+    printf("       --> Checking the cursor finds Koffing evolving into it\n");
+    assert(cursor_prev_evolution(cursor) == KOFFING_ID);
+    assert(cursor_next_evolution(cursor) == VENUSAUR_ID);
+    destroy_pokedex_cursor(cursor);
+
+    printf("    ... Saving and loading the Pokedex\n");
+    char *path = "test_pokedex_evolutions.bin";
+    assert(save_pokedex(pokedex, path) == 1);
+    Pokedex loaded = load_pokedex(path);
+    assert(loaded != NULL);
+    remove(path);
+
+    printf("       --> Checking the loaded Pokedex has the same evolutions\n");
+    change_current_pokemon(loaded, IVYSAUR_ID);
+    assert(get_prev_evolution(loaded) == KOFFING_ID);
+    change_current_pokemon(loaded, VENUSAUR_ID);
+    assert(get_prev_evolution(loaded) == BULBASAUR_ID);
+    destroy_pokedex(loaded);
+
+    printf("    ... Removing Ivysaur\n");
+    change_current_pokemon(pokedex, IVYSAUR_ID);
+    remove_pokemon(pokedex);
+
+    printf("       --> Checking Koffing no longer evolves\n");
+    change_current_pokemon(pokedex, KOFFING_ID);
+    assert(get_next_evolution(pokedex) == DOES_NOT_EVOLVE);
+    change_current_pokemon(pokedex, VENUSAUR_ID);
+    assert(get_prev_evolution(pokedex) == BULBASAUR_ID);
+
+    printf("    ... Removing Bulbasaur\n");
+    change_current_pokemon(pokedex, BULBASAUR_ID);
+    remove_pokemon(pokedex);
+
+    printf("       --> Checking no Pokemon evolves into Venusaur\n");
+    change_current_pokemon(pokedex, VENUSAUR_ID);
+    assert(get_prev_evolution(pokedex) == NO_PRE_EVOLUTION);
+    assert(get_next_evolution(pokedex) == DOES_NOT_EVOLVE);
+
+    printf("    ... Destroying the Pokedex\n");
+    destroy_pokedex(pokedex);
+
+    printf(">> Passed evolution graph tests!\n");
+}
+
+// `test_pokemon_by_id` checks whether find_pokemon_by_id and
+// remove_pokemon_by_id work on the Pokemon with the given ID without
+// moving the currently selected Pokemon (unless it is removed), and
+// whether merge_pokedexes combines query results in order of ID.
+//
+// It finds and removes Pokemon in a Pokedex of nine with Rattata
+// selected, including Rattata itself and an ID that is not there. It
+// then merges the Pokemon of the Pokedex with 'a' in their name with
+// the found Pokemon of a second Pokedex, which should give one Pokedex
+// of found Pokemon in order of ID with the first one selected.
+static void test_pokemon_by_id(void) {
+    printf("\n>> Testing find_pokemon_by_id and remove_pokemon_by_id\n");
+
+    printf("    ... Creating a Pokedex of nine Pokemon with Rattata selected\n");
+    Pokedex pokedex = create_nine_pokemon_pokedex();
+    change_current_pokemon(pokedex, RATTATA_ID);
+
+    printf("    ... Finding Weezing and Ivysaur by ID\n");
+    assert(find_pokemon_by_id(pokedex, WEEZING_ID) == 1);
+    assert(find_pokemon_by_id(pokedex, IVYSAUR_ID) == 1);
+    assert(find_pokemon_by_id(pokedex, IVYSAUR_ID) == 1);
+
+    printf("       --> Checking they are found and Rattata is still selected\n");
+    assert(count_found_pokemon(pokedex) == 2);
+    assert(pokemon_id(get_current_pokemon(pokedex)) == RATTATA_ID);
+
+    printf("       --> Checking a missing ID is not found\n");
+    assert(find_pokemon_by_id(pokedex, 999) == 0);
+    assert(count_found_pokemon(pokedex) == 2);
+
+    printf("    ... Removing Ivysaur by ID\n");
+    assert(remove_pokemon_by_id(pokedex, IVYSAUR_ID) == 1);
+
+    printf("       --> Checking the counts and that Rattata is still selected\n");
+    assert(count_total_pokemon(pokedex) == 8);
+    assert(count_found_pokemon(pokedex) == 1);
+    assert(pokemon_id(get_current_pokemon(pokedex)) == RATTATA_ID);
+
+    printf("    ... Removing Rattata by ID\n");
+    assert(remove_pokemon_by_id(pokedex, RATTATA_ID) == 1);
+
+    printf("       --> Checking Raticate is now selected\n");
+    assert(pokemon_id(get_current_pokemon(pokedex)) == RATICATE_ID);
+
+    printf("       --> Checking a missing ID is not removed\n");
+    assert(remove_pokemon_by_id(pokedex, RATTATA_ID) == 0);
+    assert(count_total_pokemon(pokedex) == 7);
+
+    printf("    ... Finding every Pokemon and searching for 'a'\n");
+    change_current_pokemon(pokedex, BULBASAUR_ID);
+    int i = 0;
+    while (i < 7) {
+        find_current_pokemon(pokedex);
+        next_pokemon(pokedex);
+        i += 1;
+    }
+    Pokedex results[2];
+    results[0] = search_pokemon(pokedex, "a");
+
+    printf("    ... Finding Ivysaur and Rattata in another Pokedex\n");
+    Pokedex other = new_pokedex();
+    add_pokemon(other, create_rattata());
+    add_pokemon(other, create_ivysaur());
+    assert(find_pokemon_by_id(other, RATTATA_ID) == 1);
+    assert(find_pokemon_by_id(other, IVYSAUR_ID) == 1);
+    results[1] = get_found_pokemon(other);
+
+    printf("    ... Merging the two results\n");
+    assert(count_total_pokemon(results[0]) == 5);
+    Pokedex merged = merge_pokedexes(results, 2);
+
+    printf("       --> Checking every Pokemon is there, found, in order of ID\n");
+    int n_results = 7;
+    assert(count_total_pokemon(merged) == n_results);
+    assert(count_found_pokemon(merged) == n_results);
+    assert(pokemon_id(get_current_pokemon(merged)) == BULBASAUR_ID);
+    int previous_id = -1;
+    i = 0;
+    while (i < n_results) {
+        assert(pokemon_id(get_current_pokemon(merged)) > previous_id);
+        previous_id = pokemon_id(get_current_pokemon(merged));
+        next_pokemon(merged);
+        i += 1;
+    }
+    change_current_pokemon(merged, IVYSAUR_ID);
+    assert(pokemon_id(get_current_pokemon(merged)) == IVYSAUR_ID);
+
+    printf("    ... Destroying the Pokedexes\n");
+    destroy_pokedex(merged);
+    destroy_pokedex(other);
+    destroy_pokedex(pokedex);
+
+    printf(">> Passed find_pokemon_by_id and remove_pokemon_by_id tests!\n");
 }
 
 ////////////////////////////////////////////////////////////////////////
 //                     Helper Functions                               //
 ////////////////////////////////////////////////////////////////////////
 
+// Creates a Pokedex holding Bulbasaur, Ivysaur, Venusaur, Rattata,
+// Raticate, Ekans, Arbok, Koffing and Weezing, in that order.
+static Pokedex create_nine_pokemon_pokedex(void) {
+    Pokedex pokedex = new_pokedex();
+    add_pokemon(pokedex, create_bulbasaur());
+    add_pokemon(pokedex, create_ivysaur());
+    add_pokemon(pokedex, create_venusaur());
+    add_pokemon(pokedex, create_rattata());
+    add_pokemon(pokedex, create_raticate());
+    add_pokemon(pokedex, create_ekans());
+    add_pokemon(pokedex, create_arbok());
+    add_pokemon(pokedex, create_koffing());
+    add_pokemon(pokedex, create_weezing());
+    return pokedex;
+}
+
+// Writes the text to a new file at the path, replacing any file there.
+static void write_test_file(char *path, char *text) {
+    FILE *file = fopen(path, "wb");
+    assert(file != NULL);
+    fputs(text, file);
+    fclose(file);
+}
+
+// Does what one thread of test_concurrent_pokedex should do to the
+// Pokedex.
+static void *use_concurrently(void *thread) {
+    struct concurrent_test_thread *t = thread;
+    int i = 0;
+    while (i < t->n_pokemon) {
+        if (t->reader) {
+            assert(count_total_pokemon(t->pokedex) >= 3);
+            Pokedex found = search_pokemon(t->pokedex, "saur");
+            assert(count_total_pokemon(found) == 3);
+            destroy_pokedex(found);
+            found = get_pokemon_of_type(t->pokedex, GRASS_TYPE);
+            assert(count_total_pokemon(found) == 3);
+            destroy_pokedex(found);
+        } else {
+            // Names of letters only, none of them with "saur" in
+            char name[] = "Concurrent";
+            name[0] = 'A' + i % 26;
+            name[1] = 'a' + i / 26;
+            add_pokemon(t->pokedex, new_pokedex_pokemon(t->pokedex,
+                t->first_id + i, name, 1.0, 1.0, NORMAL_TYPE, NONE_TYPE));
+        }
+        i += 1;
+    }
+    if (t->remove) {
+        // No other thread moves the currently selected Pokemon
+        i = 0;
+        while (i < t->n_pokemon) {
+            change_current_pokemon(t->pokedex, t->first_id + i);
+            assert(pokemon_id(get_current_pokemon(t->pokedex)) ==
+                t->first_id + i);
+            remove_pokemon(t->pokedex);
+            i += 1;
+        }
+    }
+    return NULL;
+}
+
+// Adds and finds the next 100 Pokemon with IDs from 1000 to the sharded
+// Pokedex, for test_sharded_pokedex. Each thread claims the next
+// block of IDs.
+static void *add_sharded_pokemon(void *sharded) {
+    static int next_block = 0;
+    int first_id = 1000 + 100 * __atomic_fetch_add(&next_block, 1,
+        __ATOMIC_RELAXED);
+    int i = 0;
+    while (i < 100) {
+        char name[] = "Sharded";
+        name[0] = 'A' + i % 26;
+        name[1] = 'a' + i / 26;
+        sharded_add_pokemon(sharded, new_sharded_pokemon(sharded,
+            first_id + i, name, 1.0, 1.0, NORMAL_TYPE, NONE_TYPE));
+        assert(sharded_find_pokemon(sharded, first_id + i) == 1);
+        i += 1;
+    }
+    return NULL;
+}
+
+// Explores and finds Pokemon in the concurrent Pokedex, for
+// test_concurrent_exploring. Each thread explores with its own seeds.
+static void *explore_concurrently(void *pokedex) {
+    static int next_seed = 1;
+    int seed = __atomic_fetch_add(&next_seed, 4, __ATOMIC_RELAXED);
+    int i = 0;
+    while (i < 4) {
+        go_exploring(pokedex, seed + i, 1000, 50);
+        i += 1;
+    }
+    PokedexCursor cursor = new_pokedex_cursor(pokedex);
+    i = 1000;
+    while (i < 1200) {
+        cursor_change_pokemon(cursor, i);
+        cursor_find_pokemon(cursor);
+        i += 1;
+    }
+    destroy_pokedex_cursor(cursor);
+    return NULL;
+}
+
+// Returns whether two views hold the same Pokemon in the same order,
+// moving through both of them.
+static int is_same_view(PokedexView first, PokedexView second) {
+    if (view_count(first) != view_count(second)) {
+        return 0;
+    }
+    int i = 0;
+    while (i < view_count(first)) {
+        if (view_current_pokemon(first) != view_current_pokemon(second)) {
+            return 0;
+        }
+        view_next_pokemon(first);
+        view_next_pokemon(second);
+        i += 1;
+    }
+    return 1;
+}
+
+// Counts one chunk of test_task_pools' outer task_pool_run call, and
+// runs the nested call for it.
+static void count_outer_chunk(void *counts, int chunk) {
+    struct pool_test_counts *c = counts;
+    __atomic_add_fetch(&c->outer[chunk], 1, __ATOMIC_RELAXED);
+    task_pool_run(c->pool, 10, count_nested_chunk, &c->nested[chunk]);
+}
+
+// Counts one chunk of a nested task_pool_run call of test_task_pools.
+static void count_nested_chunk(void *counts, int chunk) {
+    int *nested = counts;
+    __atomic_add_fetch(&nested[chunk], 1, __ATOMIC_RELAXED);
+}
+
+// Creates a Pokedex of n_pokemon Pokemon with IDs from 0, none found,
+// in EXPLORE_SAMPLED mode.
+static Pokedex create_exploring_pokedex(int n_pokemon) {
+    Pokedex pokedex = new_pokedex();
+    set_exploring_mode(pokedex, EXPLORE_SAMPLED);
+    int i = 0;
+    while (i < n_pokemon) {
+        char name[] = "Explored";
+        name[0] = 'A' + i % 26;
+        add_pokemon(pokedex, new_pokedex_pokemon(pokedex, i, name, 1.0, 1.0,
+            NORMAL_TYPE, NONE_TYPE));
+        i += 1;
+    }
+    return pokedex;
+}
+
 // Helper function to create Bulbasaur for testing purposes.
 static Pokemon create_bulbasaur(void) {
     Pokemon pokemon = new_pokemon(